@@ -17,6 +17,8 @@
  */
 
 #include "DABuildableWall.h"
+#include "DAWallRegistry.h"
+#include "UnrealNetwork.h"
 
 // Sets default values
 ADABuildableWall::ADABuildableWall()
@@ -25,13 +27,61 @@ ADABuildableWall::ADABuildableWall()
 	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
 	bReplicateMovement = true;
+
+	// Walls are placed upright and never move, a yaw and a whole number location are enough
+	CompactMovement.LocationQuantization = EVectorQuantization::RoundWholeNumber;
+	CompactMovement.RotationQuantization = EDARotationQuantization::YawShort;
+	CompactMovement.bReplicateVelocity = false;
 }
 
 // Called when the game starts or when spawned
 void ADABuildableWall::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if ((HasAuthority() == true) && (bUseCompactMovement == true))
+	{
+		SetReplicateMovement(false);
+	}
+
+	if (UDAWallRegistry* WallRegistry = UDAWallRegistry::Get(GetWorld()))
+	{
+		WallRegistry->RegisterWall(this);
+	}
+}
+
+void ADABuildableWall::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDAWallRegistry* WallRegistry = UDAWallRegistry::Get(GetWorld()))
+	{
+		WallRegistry->UnregisterWall(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADABuildableWall::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ADABuildableWall, CompactMovement, COND_SimulatedOnly);
+}
+
+void ADABuildableWall::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	if (bUseCompactMovement == true)
+	{
+		CompactMovement.FromActor(this);
+	}
+
+	DOREPLIFETIME_ACTIVE_OVERRIDE(ADABuildableWall, CompactMovement, bUseCompactMovement);
+}
+
+void ADABuildableWall::OnRep_CompactMovement()
+{
+	CompactMovement.ApplyTo(this);
 }
 
 // Called every frame
@@ -20,6 +20,8 @@
 
 #include "CoreMinimal.h"
 #include "Runtime/Engine/Classes/Engine/StaticMeshActor.h"
+#include "DACompactMovement.h"
+#include "DAClassRepPolicy.h"
 #include "DABuildableWall.generated.h"
 
 UCLASS()
@@ -34,9 +36,23 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** If true movement is replicated through CompactMovement instead of the default replicated movement */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	bool bUseCompactMovement = true;
+
+	UPROPERTY(EditDefaultsOnly, ReplicatedUsing=OnRep_CompactMovement, Category="Replication")
+	FDACompactMovement CompactMovement;
+
+	UFUNCTION()
+	void OnRep_CompactMovement();
 };
+
+DA_DECLARE_CLASS_REP_POLICY(ADABuildableWall, Spatialize_Static)
@@ -26,9 +26,69 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "UnrealNetwork.h"
 #include "DAWeapon.h"
+#include "DAWeaponComponent.h"
 #include "DABuildableWall.h"
+#include "DAWallRegistry.h"
+
+DECLARE_STATS_GROUP(TEXT("DACharacter"), STATGROUP_DACharacter, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Input Commands Handled"), STAT_DACharacter_InputHandled, STATGROUP_DACharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Input Commands Duplicate"), STAT_DACharacter_InputDuplicate, STATGROUP_DACharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Input Commands Rate Limited"), STAT_DACharacter_InputRateLimited, STATGROUP_DACharacter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Input Commands Bad Time"), STAT_DACharacter_InputBadTime, STATGROUP_DACharacter);
 
 FOnNewWeapon ADACharacter::OnNewWeapon;
+FOnTeamChanged ADACharacter::OnTeamChanged;
+
+bool FDAInputCommandBatch::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	Ar << FirstSequence;
+
+	uint32 NumCommands = Commands.Num();
+	Ar.SerializeInt(NumCommands, MaxCommands + 1);
+
+	if (Ar.IsLoading())
+	{
+		Commands.SetNum(NumCommands);
+	}
+
+	float FirstTime = Commands.Num() > 0 ? Commands[0].ClientTime : 0.f;
+	if (Commands.Num() > 0)
+	{
+		Ar << FirstTime;
+	}
+
+	for (int32 Idx = 0; Idx < Commands.Num(); ++Idx)
+	{
+		FDAInputCommand& Command = Commands[Idx];
+
+		uint32 Type = (uint32)Command.Type;
+		Ar.SerializeInt(Type, 2);
+		Command.Type = (EDAInputCommandType)Type;
+
+		if (Idx == 0)
+		{
+			Command.ClientTime = FirstTime;
+		}
+		else
+		{
+			uint16 OffsetMs = (uint16)FMath::Clamp(FMath::RoundToInt((Command.ClientTime - FirstTime) * 1000.f), 0, (int32)MAX_uint16);
+			Ar << OffsetMs;
+			Command.ClientTime = FirstTime + (OffsetMs / 1000.f);
+		}
+
+		if (Command.Type == EDAInputCommandType::Fire)
+		{
+			bool bLocationSuccess = true;
+			Command.MuzzleLocation.NetSerialize(Ar, Map, bLocationSuccess);
+			bOutSuccess &= bLocationSuccess;
+		}
+	}
+
+	return true;
+}
 
 //////////////////////////////////////////////////////////////////////////
 // ADACharacter
@@ -64,13 +124,24 @@ ADACharacter::ADACharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	WeaponComponent = CreateDefaultSubobject<UDAWeaponComponent>(TEXT("WeaponComponent"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
 
 void ADACharacter::StartFire()
 {
-	if ((IsLocallyControlled() == true) && (Weapon != NULL))
+	if (IsLocallyControlled() == false)
+	{
+		return;
+	}
+
+	if (bUseWeaponComponent == true)
+	{
+		WeaponComponent->FireWeapon();
+	}
+	else if (Weapon != NULL)
 	{
 		Weapon->FireWeapon();
 	}
@@ -80,34 +151,235 @@ void ADACharacter::BuildWall()
 {
 	if ((IsLocallyControlled() == true) && (WallClass != NULL))
 	{
-		ServerBuildWall();
+		SendInputCommand(EDAInputCommandType::BuildWall);
 	}
 }
 
-void ADACharacter::ServerBuildWall_Implementation()
+void ADACharacter::SpawnWall()
 {
 	FVector Location = GetActorLocation() + (GetActorForwardVector() * 200);
 	FRotator Rotation = GetActorRotation();
 
+	UDAWallRegistry* WallRegistry = UDAWallRegistry::Get(GetWorld());
+	if ((WallRegistry != nullptr) && (WallRegistry->TryBuildWall(GetController(), Location) == false))
+	{
+		return;
+	}
+
 	GetWorld()->SpawnActor<ADABuildableWall>(WallClass, Location, Rotation);
 }
-bool ADACharacter::ServerBuildWall_Validate()
+
+void ADACharacter::SendInputCommand(EDAInputCommandType Type, const FVector& MuzzleLocation)
+{
+	FDAInputCommand Command;
+	Command.Type = Type;
+	Command.MuzzleLocation = MuzzleLocation;
+	Command.ClientTime = GetWorld()->GetTimeSeconds();
+
+	if (HasAuthority() == true)
+	{
+		HandleInputCommand(Command);
+		return;
+	}
+
+	// The client applies the same cooldowns, so it does not send commands the server would drop
+	if (ConsumeInputCooldown(Command, 0.f) == false)
+	{
+		INC_DWORD_STAT(STAT_DACharacter_InputRateLimited);
+		return;
+	}
+
+	// Only the newest commands are kept, if the server hasn't acknowledged them by now they are too old to matter
+	if (PendingInputCommands.Num() == FDAInputCommandBatch::MaxCommands)
+	{
+		PendingInputCommands.RemoveAt(0, 1, false);
+	}
+
+	PendingInputCommands.Add(Command);
+	++NextInputSequence;
+
+	SendPendingInput();
+}
+
+void ADACharacter::SendPendingInput()
 {
+	FDAInputCommandBatch Batch;
+	Batch.FirstSequence = NextInputSequence - PendingInputCommands.Num();
+	Batch.Commands = PendingInputCommands;
+
+	ServerSendInput(Batch);
+
+	NextInputResendTime = GetWorld()->GetTimeSeconds() + InputResendInterval;
+}
+
+void ADACharacter::OnRep_LastAckedInputSequence()
+{
+	const uint32 FirstSequence = NextInputSequence - PendingInputCommands.Num();
+	if (LastAckedInputSequence >= FirstSequence)
+	{
+		const int32 NumAcked = FMath::Min<int32>(LastAckedInputSequence - FirstSequence + 1, PendingInputCommands.Num());
+		PendingInputCommands.RemoveAt(0, NumAcked, false);
+	}
+}
+
+void ADACharacter::ServerSendInput_Implementation(const FDAInputCommandBatch& Batch)
+{
+	for (int32 Idx = 0; Idx < Batch.Commands.Num(); ++Idx)
+	{
+		// Commands are resent until acknowledged, skip the ones already handled
+		const uint32 Sequence = Batch.FirstSequence + Idx;
+		if (Sequence <= LastAckedInputSequence)
+		{
+			INC_DWORD_STAT(STAT_DACharacter_InputDuplicate);
+			continue;
+		}
+
+		// Rejected commands are acknowledged too, resending them would not change the outcome
+		LastAckedInputSequence = Sequence;
+
+		if (IsClientInputTimeValid(Batch.Commands[Idx].ClientTime) == false)
+		{
+			INC_DWORD_STAT(STAT_DACharacter_InputBadTime);
+			continue;
+		}
+
+		HandleInputCommand(Batch.Commands[Idx]);
+	}
+}
+
+bool ADACharacter::ServerSendInput_Validate(const FDAInputCommandBatch& Batch)
+{
+	return Batch.Commands.Num() <= FDAInputCommandBatch::MaxCommands;
+}
+
+bool ADACharacter::IsClientInputTimeValid(float ClientTime)
+{
+	if (ClientTime < LastInputClientTime)
+	{
+		return false;
+	}
+
+	// A client clock that gains on the server's would shorten every cooldown, only latency jitter is tolerated
+	const float Offset = GetWorld()->GetTimeSeconds() - ClientTime;
+	if (bHasInputTimeOffset == false)
+	{
+		InputTimeOffset = Offset;
+		bHasInputTimeOffset = true;
+	}
+	else if (Offset < InputTimeOffset - MaxInputTimeDrift)
+	{
+		return false;
+	}
+
+	LastInputClientTime = ClientTime;
 	return true;
 }
 
+bool ADACharacter::ConsumeInputCooldown(const FDAInputCommand& Command, float Tolerance)
+{
+	// Checked against the time the command was issued, so commands delayed or resent after packet loss are not dropped
+	switch (Command.Type)
+	{
+	case EDAInputCommandType::Fire:
+	{
+		if (Command.ClientTime + Tolerance < NextFireTime)
+		{
+			return false;
+		}
+
+		NextFireTime = Command.ClientTime + GetFireCooldown();
+		return true;
+	}
+
+	case EDAInputCommandType::BuildWall:
+	{
+		if ((Command.ClientTime + Tolerance < NextBuildTime) || (WallClass == NULL))
+		{
+			return false;
+		}
+
+		NextBuildTime = Command.ClientTime + BuildCooldown;
+		return true;
+	}
+	}
+
+	return false;
+}
+
+void ADACharacter::HandleInputCommand(const FDAInputCommand& Command)
+{
+	if (ConsumeInputCooldown(Command, InputCooldownTolerance) == false)
+	{
+		INC_DWORD_STAT(STAT_DACharacter_InputRateLimited);
+		return;
+	}
+
+	switch (Command.Type)
+	{
+	case EDAInputCommandType::Fire:
+	{
+		if (bUseWeaponComponent == true)
+		{
+			WeaponComponent->ServerFireWeapon(Command.MuzzleLocation);
+		}
+		else if (Weapon != NULL)
+		{
+			Weapon->ServerFireWeapon(Command.MuzzleLocation);
+		}
+		break;
+	}
+
+	case EDAInputCommandType::BuildWall:
+	{
+		SpawnWall();
+		break;
+	}
+	}
+
+	INC_DWORD_STAT(STAT_DACharacter_InputHandled);
+}
+
+float ADACharacter::GetFireCooldown() const
+{
+	if (bUseWeaponComponent == true)
+	{
+		return WeaponComponent->WeaponClass != NULL ? WeaponComponent->WeaponClass->GetDefaultObject<ADAWeapon>()->FireCooldown : 0.f;
+	}
+
+	return Weapon != NULL ? Weapon->FireCooldown : 0.f;
+}
+
+void ADACharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if ((PendingInputCommands.Num() > 0) && (GetWorld()->GetTimeSeconds() >= NextInputResendTime))
+	{
+		SendPendingInput();
+	}
+}
+
 void ADACharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if ((Role > ROLE_AutonomousProxy) && (WeaponClass != NULL))
+	if ((Role > ROLE_AutonomousProxy) && (WeaponClass != NULL) && (bUseWeaponComponent == true))
+	{
+		WeaponComponent->SetIsReplicated(true);
+		WeaponComponent->InitWeapon(WeaponClass, AttachSocketName);
+	}
+	else if ((Role > ROLE_AutonomousProxy) && (WeaponClass != NULL))
 	{
 		Weapon = GetWorld()->SpawnActor<ADAWeapon>(WeaponClass, FTransform());
 		if (Weapon != nullptr)
 		{
 			Weapon->OwnerPawn = this;
+			Weapon->SetOwner(this);
 			Weapon->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, false), AttachSocketName);
 
+			// The attachment is replicated on its own, movement updates would only repeat the socket transform
+			Weapon->SetReplicateMovement(false);
+
 			OnNewWeapon.Broadcast(this, Weapon, NULL);
 		}
 	}
@@ -117,18 +389,21 @@ void ADACharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLife
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	DOREPLIFETIME(ADACharacter, Weapon);
+	DOREPLIFETIME(ADACharacter, TeamId);
+	DOREPLIFETIME_CONDITION(ADACharacter, LastAckedInputSequence, COND_OwnerOnly);
 }
 
-void ADACharacter::ServerFireWeapon_Implementation(const FVector& MuzzleLocation)
+void ADACharacter::SetTeam(uint8 NewTeam)
 {
-	if (Weapon != NULL)
+	if ((HasAuthority() == false) || (NewTeam == TeamId))
 	{
-		Weapon->ServerFireWeapon(MuzzleLocation);
+		return;
 	}
-}
-bool ADACharacter::ServerFireWeapon_Validate(const FVector& MuzzleLocation)
-{
-	return true;
+
+	const uint8 OldTeam = TeamId;
+	TeamId = NewTeam;
+
+	OnTeamChanged.Broadcast(this, OldTeam, NewTeam);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -20,9 +20,59 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Engine/NetSerialization.h"
+#include "DAClassRepPolicy.h"
 #include "DACharacter.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnNewWeapon, class ADACharacter*, class ADAWeapon* /* New Weapon */, class ADAWeapon* /* OldWeapon */)
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnTeamChanged, class ADACharacter*, uint8 /* OldTeam */, uint8 /* NewTeam */)
+
+enum class EDAInputCommandType : uint8
+{
+	Fire,
+	BuildWall
+};
+
+/** A fire or build input sent to the server */
+struct FDAInputCommand
+{
+	EDAInputCommandType Type = EDAInputCommandType::Fire;
+	FVector_NetQuantize MuzzleLocation = FVector::ZeroVector;
+
+	/** World time of the client when the command was issued, the cooldowns are checked against it */
+	float ClientTime = 0.f;
+};
+
+/**
+ * The input commands the server has not acknowledged yet
+ *
+ * Sent unreliably and resent until acknowledged, the server skips the commands it already handled by their sequence.
+ * The client time of the first command is sent in full, the others as a millisecond offset from it.
+ */
+USTRUCT()
+struct FDAInputCommandBatch
+{
+	GENERATED_BODY()
+
+	/** Max number of unacknowledged commands, older ones are dropped */
+	static const int32 MaxCommands = 8;
+
+	/** Sequence of the first command, the sequence of the others follow */
+	uint32 FirstSequence = 0;
+
+	TArray<FDAInputCommand, TInlineAllocator<MaxCommands>> Commands;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FDAInputCommandBatch> : public TStructOpsTypeTraitsBase2<FDAInputCommandBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
 
 UCLASS(config=Game)
 class ADACharacter : public ACharacter
@@ -40,6 +90,14 @@ public:
 	ADACharacter();
 
 	static FOnNewWeapon OnNewWeapon;
+	static FOnTeamChanged OnTeamChanged;
+
+	static const uint8 NoTeam = 255;
+
+	/** Changes the team of the character, only on the server */
+	void SetTeam(uint8 NewTeam);
+
+	uint8 GetTeam() const { return TeamId; }
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -49,19 +107,54 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseLookUpRate;
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerFireWeapon(const FVector& MuzzleLocation);
+	/** Sends a fire or build command to the server, on the server it is handled right away */
+	void SendInputCommand(EDAInputCommandType Type, const FVector& MuzzleLocation = FVector::ZeroVector);
+
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerSendInput(const FDAInputCommandBatch& Batch);
+
+	/** Sequence of the last input command the server has handled */
+	UPROPERTY(ReplicatedUsing=OnRep_LastAckedInputSequence)
+	uint32 LastAckedInputSequence = 0;
+
+	/** How often unacknowledged input commands are resent */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Character")
+	float InputResendInterval = 0.05f;
+
+	/** Min time between two walls built by this character */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Character")
+	float BuildCooldown = 0.5f;
+
+	/** How much earlier than its cooldown the server still accepts a command, covers the millisecond time quantization */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Character")
+	float InputCooldownTolerance = 0.005f;
+
+	/** How far the client's command times may run ahead of the server's clock since its first command, covers latency jitter */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Character")
+	float MaxInputTimeDrift = 0.25f;
 
 	UPROPERTY(Replicated)
 	class ADAWeapon* Weapon;
 
+	/** NoTeam outside of team modes */
+	UPROPERTY(Replicated)
+	uint8 TeamId = NoTeam;
+
+	/** Replicates the weapon as part of the character when bUseWeaponComponent is set */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Character")
+	class UDAWeaponComponent* WeaponComponent;
+
+	/**
+	 * If true the weapon replicates through WeaponComponent and its mesh is spawned locally on every client,
+	 * instead of spawning a replicated ADAWeapon that needs its own actor channel
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Character")
+	bool bUseWeaponComponent = false;
+
 	virtual void StartFire();
 
 	virtual void BuildWall();
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerBuildWall();
-
 	UPROPERTY(EditDefaultsOnly, Category="Character")
 	TSubclassOf<class ADAWeapon> WeaponClass;
 
@@ -72,9 +165,44 @@ public:
 	FName AttachSocketName = TEXT("WeaponSocket");
 
 	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
 
 protected:
 
+	/** Handles an input command on the server */
+	void HandleInputCommand(const FDAInputCommand& Command);
+
+	/** Starts the cooldown of the command if it is over at the command's time, false if the command has to be dropped */
+	bool ConsumeInputCooldown(const FDAInputCommand& Command, float Tolerance);
+
+	/** False if the client time of the command runs backwards or further ahead of the server than MaxInputTimeDrift */
+	bool IsClientInputTimeValid(float ClientTime);
+
+	/** Spawns a wall in front of the character, server only */
+	void SpawnWall();
+
+	/** Time between shots of the current weapon */
+	float GetFireCooldown() const;
+
+	void SendPendingInput();
+
+	UFUNCTION()
+	void OnRep_LastAckedInputSequence();
+
+	/** Commands sent to the server that have not been acknowledged yet */
+	TArray<FDAInputCommand, TInlineAllocator<FDAInputCommandBatch::MaxCommands>> PendingInputCommands;
+
+	uint32 NextInputSequence = 1;
+	float NextInputResendTime = 0.f;
+
+	float NextFireTime = 0.f;
+	float NextBuildTime = 0.f;
+
+	/** Server time minus client time of the first command received, the client's clock may not gain on it */
+	float InputTimeOffset = 0.f;
+	float LastInputClientTime = 0.f;
+	bool bHasInputTimeOffset = false;
+
 	/** Resets HMD orientation in VR. */
 	void OnResetVR();
 
@@ -114,3 +242,4 @@ public:
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 };
 
+DA_DECLARE_CLASS_REP_POLICY(ADACharacter, Spatialize_Character)
@@ -0,0 +1,60 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DAClassRepPolicy.generated.h"
+
+UENUM()
+enum class EClassRepPolicy : uint8
+{
+	NotRouted,
+	RelevantAllConnections,
+
+	// --------------------------------
+	// Spatialized routes into the grid node
+
+	Spatialize_Static,		// Used for actors for frequent updates / updates every frame
+	Spatialize_Dynamic,		// For do need updates every frame
+	Spatialize_Dormancy,	// Actors that can either be Static or Dynamic determined by their AActor::NetDormancy state
+	Spatialize_Packed,		// Dynamic actors with short cull distances, culled per cell by the packed grid node
+	Spatialize_Character	// Characters, kept in their own packed grid so they are not tested together with projectiles
+};
+
+/**
+ * Routing policy of a native class, known at compile time
+ *
+ * Native classes opt in with DA_DECLARE_CLASS_REP_POLICY after their declaration. The replication graph registers
+ * them without scanning their class defaults, Blueprint subclasses inherit the policy through the class map.
+ */
+template<typename T>
+struct TDAClassRepPolicy
+{
+	static constexpr bool bDeclared = false;
+};
+
+#define DA_DECLARE_CLASS_REP_POLICY(ClassName, PolicyName) \
+	template<> \
+	struct TDAClassRepPolicy<ClassName> \
+	{ \
+		static constexpr bool bDeclared = true; \
+		static constexpr EClassRepPolicy Policy = EClassRepPolicy::PolicyName; \
+	};
@@ -0,0 +1,254 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+
+#include "DACompactMovement.h"
+#include "Engine/NetSerialization.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "DAProjectile.h"
+#include "DABuildableWall.h"
+
+namespace
+{
+	bool SerializeQuantizedVector(FArchive& Ar, FVector& Vector, EVectorQuantization Quantization)
+	{
+		switch (Quantization)
+		{
+		case EVectorQuantization::RoundTwoDecimals:
+			return SerializePackedVector<100, 30>(Vector, Ar);
+
+		case EVectorQuantization::RoundOneDecimal:
+			return SerializePackedVector<10, 27>(Vector, Ar);
+
+		default:
+			return SerializePackedVector<1, 24>(Vector, Ar);
+		}
+	}
+
+	// Steps of the velocity direction and speed when sent as a direction and a speed
+	const uint32 VelocityYawSteps = 1 << 12;
+	const uint32 VelocityPitchSteps = 1 << 11;
+	const uint32 VelocitySpeedSteps = 1 << 15;
+
+	struct FPackedVelocity
+	{
+		uint32 Yaw = 0;
+		uint32 Pitch = 0;
+		uint32 Speed = 0;
+	};
+
+	/** Returns false if the speed had to be clamped */
+	bool PackVelocity(const FVector& Velocity, FPackedVelocity& OutPacked)
+	{
+		const FRotator Direction = Velocity.Rotation();
+		const int32 Speed = FMath::RoundToInt(Velocity.Size());
+
+		OutPacked.Yaw = (uint32)FMath::RoundToInt(FRotator::ClampAxis(Direction.Yaw) * (VelocityYawSteps / 360.f)) % VelocityYawSteps;
+		OutPacked.Pitch = (uint32)FMath::Clamp(FMath::RoundToInt((Direction.Pitch + 90.f) * ((VelocityPitchSteps - 1) / 180.f)), 0, (int32)VelocityPitchSteps - 1);
+		OutPacked.Speed = (uint32)FMath::Min(Speed, (int32)VelocitySpeedSteps - 1);
+
+		return Speed < (int32)VelocitySpeedSteps;
+	}
+
+	FVector UnpackVelocity(const FPackedVelocity& Packed)
+	{
+		const float Yaw = Packed.Yaw * (360.f / VelocityYawSteps);
+		const float Pitch = Packed.Pitch * (180.f / (VelocityPitchSteps - 1)) - 90.f;
+
+		return FRotator(Pitch, Yaw, 0.f).Vector() * (float)Packed.Speed;
+	}
+
+	FVector QuantizeVector(const FVector& Vector, EVectorQuantization Quantization)
+	{
+		switch (Quantization)
+		{
+		case EVectorQuantization::RoundTwoDecimals:
+			return FVector(FMath::RoundToFloat(Vector.X * 100.f) / 100.f, FMath::RoundToFloat(Vector.Y * 100.f) / 100.f, FMath::RoundToFloat(Vector.Z * 100.f) / 100.f);
+
+		case EVectorQuantization::RoundOneDecimal:
+			return FVector(FMath::RoundToFloat(Vector.X * 10.f) / 10.f, FMath::RoundToFloat(Vector.Y * 10.f) / 10.f, FMath::RoundToFloat(Vector.Z * 10.f) / 10.f);
+
+		default:
+			return FVector(FMath::RoundToFloat(Vector.X), FMath::RoundToFloat(Vector.Y), FMath::RoundToFloat(Vector.Z));
+		}
+	}
+}
+
+void FDACompactMovement::FromActor(const AActor* Actor)
+{
+	Location = QuantizeVector(Actor->GetActorLocation(), LocationQuantization);
+	Velocity = FVector::ZeroVector;
+
+	if (bReplicateVelocity == true)
+	{
+		if (bVelocityAsDirectionAndSpeed == true)
+		{
+			FPackedVelocity Packed;
+			PackVelocity(Actor->GetVelocity(), Packed);
+			Velocity = UnpackVelocity(Packed);
+		}
+		else
+		{
+			Velocity = QuantizeVector(Actor->GetVelocity(), VelocityQuantization);
+		}
+	}
+
+	const FRotator ActorRotation = Actor->GetActorRotation();
+	switch (RotationQuantization)
+	{
+	case EDARotationQuantization::ShortComponents:
+		Rotation = FRotator(FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ActorRotation.Pitch)),
+			FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ActorRotation.Yaw)),
+			FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ActorRotation.Roll)));
+		break;
+
+	case EDARotationQuantization::YawShort:
+		Rotation = FRotator(0.f, FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ActorRotation.Yaw)), 0.f);
+		break;
+
+	case EDARotationQuantization::YawByte:
+		Rotation = FRotator(0.f, FRotator::DecompressAxisFromByte(FRotator::CompressAxisToByte(ActorRotation.Yaw)), 0.f);
+		break;
+
+	case EDARotationQuantization::FromVelocity:
+		Rotation = FRotator::ZeroRotator;
+		break;
+	}
+}
+
+void FDACompactMovement::ApplyTo(AActor* Actor) const
+{
+	if (Actor->Role != ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	Actor->ReplicatedMovement.Location = Location;
+	Actor->ReplicatedMovement.Rotation = RotationQuantization == EDARotationQuantization::FromVelocity ? Velocity.Rotation() : Rotation;
+	Actor->ReplicatedMovement.LinearVelocity = Velocity;
+	Actor->ReplicatedMovement.bRepPhysics = false;
+	Actor->OnRep_ReplicatedMovement();
+}
+
+bool FDACompactMovement::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = SerializeQuantizedVector(Ar, Location, LocationQuantization);
+
+	switch (RotationQuantization)
+	{
+	case EDARotationQuantization::ShortComponents:
+	{
+		Rotation.SerializeCompressedShort(Ar);
+		break;
+	}
+
+	case EDARotationQuantization::YawShort:
+	{
+		uint16 Yaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+		Ar << Yaw;
+		Rotation = FRotator(0.f, FRotator::DecompressAxisFromShort(Yaw), 0.f);
+		break;
+	}
+
+	case EDARotationQuantization::YawByte:
+	{
+		uint8 Yaw = FRotator::CompressAxisToByte(Rotation.Yaw);
+		Ar << Yaw;
+		Rotation = FRotator(0.f, FRotator::DecompressAxisFromByte(Yaw), 0.f);
+		break;
+	}
+
+	case EDARotationQuantization::FromVelocity:
+	{
+		break;
+	}
+	}
+
+	if ((bReplicateVelocity == true) && (bVelocityAsDirectionAndSpeed == true))
+	{
+		FPackedVelocity Packed;
+		if (Ar.IsSaving() == true)
+		{
+			bOutSuccess &= PackVelocity(Velocity, Packed);
+		}
+
+		Ar.SerializeInt(Packed.Yaw, VelocityYawSteps);
+		Ar.SerializeInt(Packed.Pitch, VelocityPitchSteps);
+		Ar.SerializeInt(Packed.Speed, VelocitySpeedSteps);
+
+		if (Ar.IsLoading() == true)
+		{
+			Velocity = UnpackVelocity(Packed);
+		}
+	}
+	else if (bReplicateVelocity == true)
+	{
+		bOutSuccess &= SerializeQuantizedVector(Ar, Velocity, VelocityQuantization);
+	}
+
+	return true;
+}
+
+namespace
+{
+	/** Serializes a movement the way a replicated property would be sent and returns the bit count */
+	template<typename MovementType>
+	int64 MeasureBits(MovementType& Movement)
+	{
+		FNetBitWriter Writer(nullptr, 1024);
+		bool bSuccess = true;
+		Movement.NetSerialize(Writer, nullptr, bSuccess);
+		return Writer.GetNumBits();
+	}
+
+	void ReportMovementBits(const TCHAR* Name, const AActor* DefaultActor, FDACompactMovement Compact, const FVector& Location, const FRotator& Rotation, const FVector& Velocity, FOutputDevice& Ar)
+	{
+		FRepMovement Full = DefaultActor->ReplicatedMovement;
+		Full.Location = Location;
+		Full.Rotation = Rotation;
+		Full.LinearVelocity = Velocity;
+
+		Compact.Location = Location;
+		Compact.Rotation = Rotation;
+		Compact.Velocity = Velocity;
+
+		const int64 FullBits = MeasureBits(Full);
+		const int64 CompactBits = MeasureBits(Compact);
+
+		Ar.Logf(TEXT("%s: FRepMovement %lld bits, compact %lld bits (%.0f%%)"), Name, FullBits, CompactBits, FullBits > 0 ? 100.f * CompactBits / FullBits : 0.f);
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice MovementBitsCommand(
+	TEXT("DA.MovementBits"),
+	TEXT("Prints the bits per movement update of FRepMovement and the compact movement profiles"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateStatic([](FOutputDevice& Ar)
+	{
+		// A projectile and a wall far from the origin, where the packed vectors need the most bits
+		const FVector Location(123456.78f, -98765.43f, 1234.56f);
+
+		const FVector ProjectileVelocity(5656.85f, 5656.85f, -120.f);
+		const ADAProjectile* Projectile = GetDefault<ADAProjectile>();
+		ReportMovementBits(TEXT("Projectile"), Projectile, Projectile->CompactMovement, Location, ProjectileVelocity.Rotation(), ProjectileVelocity, Ar);
+
+		const ADABuildableWall* Wall = GetDefault<ADABuildableWall>();
+		ReportMovementBits(TEXT("Wall"), Wall, Wall->CompactMovement, Location, FRotator(0.f, 37.5f, 0.f), FVector::ZeroVector, Ar);
+	}));
@@ -0,0 +1,99 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "DACompactMovement.generated.h"
+
+UENUM()
+enum class EDARotationQuantization : uint8
+{
+	ShortComponents,	// Pitch, yaw and roll as shorts
+	YawShort,			// Only yaw as a short, pitch and roll are zero
+	YawByte,			// Only yaw as a byte
+	FromVelocity		// Nothing is sent, the receiver faces the actor along its velocity
+};
+
+/**
+ * Movement replicated with a per-class quantization profile instead of FRepMovement's defaults
+ *
+ * Like FRepMovement the profile is never sent, both sides read it from the class defaults of the owning actor.
+ */
+USTRUCT()
+struct DAREPGRAPHEXAMPLE_API FDACompactMovement
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY()
+	FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	EVectorQuantization LocationQuantization = EVectorQuantization::RoundWholeNumber;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	EDARotationQuantization RotationQuantization = EDARotationQuantization::ShortComponents;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	EVectorQuantization VelocityQuantization = EVectorQuantization::RoundWholeNumber;
+
+	/** Static actors can skip the velocity */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	bool bReplicateVelocity = true;
+
+	/**
+	 * Sends the velocity as a direction and a speed instead of VelocityQuantization, for actors that fly straight like projectiles.
+	 * The direction has a 0.09 degree step and the speed is in whole units up to 32767
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	bool bVelocityAsDirectionAndSpeed = false;
+
+	/** Copies the current movement of the actor, quantized so property comparison ignores changes too small to be sent */
+	void FromActor(const AActor* Actor);
+
+	/** Feeds the movement to a simulated proxy through the regular replicated movement path */
+	void ApplyTo(AActor* Actor) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FDACompactMovement& Other) const
+	{
+		return Location == Other.Location && Rotation == Other.Rotation && Velocity == Other.Velocity;
+	}
+	bool operator!=(const FDACompactMovement& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FDACompactMovement> : public TStructOpsTypeTraitsBase2<FDACompactMovement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
@@ -0,0 +1,132 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DAFireQueue.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "DAProjectile.h"
+#include "DARepGraphExampleGameMode.h"
+
+DECLARE_STATS_GROUP(TEXT("DAFireQueue"), STATGROUP_DAFireQueue, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Flush"), STAT_DAFireQueue_Flush, STATGROUP_DAFireQueue);
+DECLARE_CYCLE_STAT(TEXT("Aim Trace Done"), STAT_DAFireQueue_AimTraceDone, STATGROUP_DAFireQueue);
+DECLARE_CYCLE_STAT(TEXT("Sync Aim Trace"), STAT_DAFireQueue_SyncAimTrace, STATGROUP_DAFireQueue);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Aim Traces"), STAT_DAFireQueue_AimTraces, STATGROUP_DAFireQueue);
+
+UDAFireQueue* UDAFireQueue::Get(UWorld* World)
+{
+	ADARepGraphExampleGameMode* GameMode = World != NULL ? World->GetAuthGameMode<ADARepGraphExampleGameMode>() : nullptr;
+	return GameMode != nullptr ? GameMode->FireQueue : nullptr;
+}
+
+void UDAFireQueue::QueueFire(APawn* Instigator, TSubclassOf<ADAProjectile> ProjectileClass, const FVector& MuzzleLocation)
+{
+	if ((Instigator == NULL) || (ProjectileClass == NULL))
+	{
+		return;
+	}
+
+	FVector EyesLocation;
+	FRotator EyesRotation;
+	Instigator->GetActorEyesViewPoint(EyesLocation, EyesRotation);
+
+	const FVector TraceEnd = EyesLocation + EyesRotation.Vector() * MaxAimTraceRange;
+
+	if (bUseAsyncAimTraces == false)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DAFireQueue_SyncAimTrace);
+		INC_DWORD_STAT(STAT_DAFireQueue_AimTraces);
+
+		FHitResult OutHit(ForceInit);
+		const bool bHit = Instigator->GetWorld()->LineTraceSingleByChannel(OutHit, EyesLocation, TraceEnd, ECC_Visibility);
+
+		SpawnProjectile(Instigator->GetWorld(), ProjectileClass, MuzzleLocation, bHit ? OutHit.Location : TraceEnd);
+		return;
+	}
+
+	FDAFireRequest& Request = QueuedRequests.AddDefaulted_GetRef();
+	Request.Instigator = Instigator;
+	Request.ProjectileClass = ProjectileClass;
+	Request.MuzzleLocation = MuzzleLocation;
+	Request.TraceStart = EyesLocation;
+	Request.TraceEnd = TraceEnd;
+}
+
+void UDAFireQueue::Flush(UWorld* World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAFireQueue_Flush);
+
+	if ((QueuedRequests.Num() == 0) || (World == NULL))
+	{
+		return;
+	}
+
+	if (AimTraceDelegate.IsBound() == false)
+	{
+		AimTraceDelegate.BindUObject(this, &UDAFireQueue::OnAimTraceDone);
+	}
+
+	for (const FDAFireRequest& Request : QueuedRequests)
+	{
+		APawn* Instigator = Request.Instigator.Get();
+		if (Instigator == NULL)
+		{
+			continue;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(DAAimTrace), false, Instigator);
+
+		const uint32 RequestId = NextRequestId++;
+		TracingRequests.Add(RequestId, Request);
+
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Request.TraceStart, Request.TraceEnd, ECC_Visibility, QueryParams, FCollisionResponseParams::DefaultResponseParam, &AimTraceDelegate, RequestId);
+	}
+
+	INC_DWORD_STAT_BY(STAT_DAFireQueue_AimTraces, QueuedRequests.Num());
+	QueuedRequests.Reset();
+}
+
+void UDAFireQueue::OnAimTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAFireQueue_AimTraceDone);
+
+	FDAFireRequest Request;
+	if (TracingRequests.RemoveAndCopyValue(TraceDatum.UserData, Request) == false)
+	{
+		return;
+	}
+
+	const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+	const FVector AimLocation = Hit != nullptr ? Hit->Location : Request.TraceEnd;
+
+	SpawnProjectile(TraceDatum.PhysWorld.Get(), Request.ProjectileClass, Request.MuzzleLocation, AimLocation);
+}
+
+void UDAFireQueue::SpawnProjectile(UWorld* World, TSubclassOf<ADAProjectile> ProjectileClass, const FVector& MuzzleLocation, const FVector& AimLocation)
+{
+	if ((World == NULL) || (ProjectileClass == NULL))
+	{
+		return;
+	}
+
+	FRotator Direction = (AimLocation - MuzzleLocation).Rotation();
+	World->SpawnActor<ADAProjectile>(ProjectileClass, FTransform(Direction, MuzzleLocation, FVector(0.25f, 0.25f, 0.25f)));
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "WorldCollision.h"
+#include "DAFireQueue.generated.h"
+
+class ADAProjectile;
+
+/** A shot waiting for its aim trace */
+struct FDAFireRequest
+{
+	TWeakObjectPtr<APawn> Instigator;
+	TSubclassOf<ADAProjectile> ProjectileClass;
+	FVector MuzzleLocation;
+	FVector TraceStart;
+	FVector TraceEnd;
+};
+
+/**
+ * Collects the server fire requests of a frame and resolves their aim traces asynchronously
+ *
+ * Every request queued during a frame is traced in one batch when the queue is flushed,
+ * the projectiles are spawned on the next frame when the trace results are in.
+ */
+UCLASS(config=Game)
+class DAREPGRAPHEXAMPLE_API UDAFireQueue : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Queues a shot from the eyes of the instigator, or fires it right away if async aim traces are disabled */
+	void QueueFire(APawn* Instigator, TSubclassOf<ADAProjectile> ProjectileClass, const FVector& MuzzleLocation);
+
+	/** Issues the aim traces for every shot queued since the last flush */
+	void Flush(UWorld* World);
+
+	/** Gets the fire queue of the world's game mode, only valid on the server */
+	static UDAFireQueue* Get(UWorld* World);
+
+	/** Spawns a projectile from the muzzle towards the aim location */
+	static void SpawnProjectile(UWorld* World, TSubclassOf<ADAProjectile> ProjectileClass, const FVector& MuzzleLocation, const FVector& AimLocation);
+
+	UPROPERTY(config)
+	bool bUseAsyncAimTraces = true;
+
+	/** How far the aim trace goes, if it hits nothing the projectile is aimed at the end of the trace */
+	UPROPERTY(config)
+	float MaxAimTraceRange = 50000.f;
+
+protected:
+
+	void OnAimTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	TArray<FDAFireRequest> QueuedRequests;
+
+	/** Requests with a trace in flight, keyed by the user data passed to the trace */
+	TMap<uint32, FDAFireRequest> TracingRequests;
+
+	uint32 NextRequestId = 0;
+
+	FTraceDelegate AimTraceDelegate;
+};
@@ -17,6 +17,16 @@
  */
 
 #include "DAProjectile.h"
+#include "UnrealNetwork.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+
+DECLARE_STATS_GROUP(TEXT("DAProjectile"), STATGROUP_DAProjectile, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Forced Updates"), STAT_DAProjectile_ForcedUpdates, STATGROUP_DAProjectile);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Blended Corrections"), STAT_DAProjectile_BlendedCorrections, STATGROUP_DAProjectile);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapped Corrections"), STAT_DAProjectile_SnappedCorrections, STATGROUP_DAProjectile);
 
 // Sets default values
 ADAProjectile::ADAProjectile()
@@ -36,6 +46,12 @@ ADAProjectile::ADAProjectile()
 	bReplicates = true;
 	bReplicateMovement = true;
 
+	// Rotation follows velocity, so only the location and velocity have to be sent. Projectiles fly straight at a
+	// nearly constant speed, a direction and a speed are cheaper than a packed vector
+	CompactMovement.LocationQuantization = EVectorQuantization::RoundWholeNumber;
+	CompactMovement.RotationQuantization = EDARotationQuantization::FromVelocity;
+	CompactMovement.bVelocityAsDirectionAndSpeed = true;
+
 	SetMobility(EComponentMobility::Movable);
 }
 
@@ -43,12 +59,82 @@ ADAProjectile::ADAProjectile()
 void ADAProjectile::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if ((HasAuthority() == true) && (bUseCompactMovement == true))
+	{
+		SetReplicateMovement(false);
+	}
+}
+
+void ADAProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ADAProjectile, CompactMovement, COND_SimulatedOnly);
+}
+
+void ADAProjectile::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	if (bUseCompactMovement == true)
+	{
+		CompactMovement.FromActor(this);
+	}
+
+	LastSentLocation = GetActorLocation();
+	LastSentVelocity = GetVelocity();
+	LastSentTime = GetWorld()->GetTimeSeconds();
+
+	DOREPLIFETIME_ACTIVE_OVERRIDE(ADAProjectile, CompactMovement, bUseCompactMovement);
+}
+
+void ADAProjectile::OnRep_CompactMovement()
+{
+	CompactMovement.ApplyTo(this);
 }
 
 // Called every frame
 void ADAProjectile::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	if (bUseExtrapolation == false)
+	{
+		return;
+	}
+
+	if (HasAuthority() == true)
+	{
+		// Bounces and hits are the only thing clients can not extrapolate, those are sent right away instead of waiting for the replication period
+		if (LastSentTime >= 0.f)
+		{
+			const FVector Extrapolated = ExtrapolateLocation(LastSentLocation, LastSentVelocity, GetWorld()->GetTimeSeconds() - LastSentTime);
+			if (FVector::DistSquared(Extrapolated, GetActorLocation()) > FMath::Square(ExtrapolationTolerance))
+			{
+				ForceNetUpdate();
+				INC_DWORD_STAT(STAT_DAProjectile_ForcedUpdates);
+
+				// Stop forcing until the update is out
+				LastSentTime = -1.f;
+			}
+		}
+	}
+	else if (CorrectionTimeLeft > 0.f)
+	{
+		const float Alpha = FMath::Min(DeltaTime / CorrectionTimeLeft, 1.f);
+		const FVector Step = RemainingCorrection * Alpha;
+
+		AddActorWorldOffset(Step);
+		RemainingCorrection -= Step;
+		CorrectionTimeLeft -= DeltaTime;
+	}
+}
+
+FVector ADAProjectile::ExtrapolateLocation(const FVector& Location, const FVector& Velocity, float Time) const
+{
+	const FVector Gravity(0.f, 0.f, ProjMovement->GetGravityZ());
+	return Location + (Velocity * Time) + (0.5f * Gravity * Time * Time);
 }
 
 void ADAProjectile::PostNetReceiveVelocity(const FVector& NewVelocity)
@@ -56,3 +142,37 @@ void ADAProjectile::PostNetReceiveVelocity(const FVector& NewVelocity)
 	ProjMovement->Velocity = NewVelocity;
 }
 
+void ADAProjectile::PostNetReceiveLocationAndRotation()
+{
+	if ((bUseExtrapolation == false) || (Role != ROLE_SimulatedProxy))
+	{
+		Super::PostNetReceiveLocationAndRotation();
+		return;
+	}
+
+	// The update is half a round trip old, move it forward to where the server has the projectile now
+	float Latency = 0.f;
+	APlayerController* LocalController = GetWorld()->GetFirstPlayerController();
+	if ((LocalController != NULL) && (LocalController->PlayerState != NULL))
+	{
+		Latency = LocalController->PlayerState->ExactPing * 0.0005f;
+	}
+
+	const FVector ReceivedLocation = FRepMovement::RebaseOntoLocalOrigin(ReplicatedMovement.Location, this);
+	const FVector Target = ExtrapolateLocation(ReceivedLocation, ReplicatedMovement.LinearVelocity, Latency);
+	const FVector Correction = Target - GetActorLocation();
+
+	if (Correction.SizeSquared() > FMath::Square(MaxBlendedCorrection))
+	{
+		SetActorLocationAndRotation(Target, ReplicatedMovement.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		RemainingCorrection = FVector::ZeroVector;
+		CorrectionTimeLeft = 0.f;
+		INC_DWORD_STAT(STAT_DAProjectile_SnappedCorrections);
+		return;
+	}
+
+	// Small errors are blended out over a few frames instead of popping the projectile
+	RemainingCorrection = Correction;
+	CorrectionTimeLeft = CorrectionBlendTime;
+	INC_DWORD_STAT(STAT_DAProjectile_BlendedCorrections);
+}
@@ -21,6 +21,8 @@
 #include "CoreMinimal.h"
 #include "Runtime/Engine/Classes/Engine/StaticMeshActor.h"
 #include "Runtime/Engine/Classes/GameFramework/ProjectileMovementComponent.h"
+#include "DACompactMovement.h"
+#include "DAClassRepPolicy.h"
 #include "DAProjectile.generated.h"
 
 UCLASS()
@@ -44,4 +46,51 @@ public:
 	virtual void Tick(float DeltaTime) override;
 
 	virtual void PostNetReceiveVelocity(const FVector& NewVelocity) override;
+	virtual void PostNetReceiveLocationAndRotation() override;
+
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** If true movement is replicated through CompactMovement instead of the default replicated movement */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	bool bUseCompactMovement = true;
+
+	UPROPERTY(EditDefaultsOnly, ReplicatedUsing=OnRep_CompactMovement, Category="Replication")
+	FDACompactMovement CompactMovement;
+
+	UFUNCTION()
+	void OnRep_CompactMovement();
+
+	/**
+	 * If true clients extrapolate the projectile between updates and blend out corrections, and the server only
+	 * forces an update when the client extrapolation drifts further than ExtrapolationTolerance
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	bool bUseExtrapolation = true;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float ExtrapolationTolerance = 50.f;
+
+	/** Corrections larger than this are snapped instead of blended */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float MaxBlendedCorrection = 500.f;
+
+	/** Time a correction is blended out over */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float CorrectionBlendTime = 0.1f;
+
+	/** Where the projectile is after Time seconds of ballistic flight, the same way clients extrapolate it */
+	FVector ExtrapolateLocation(const FVector& Location, const FVector& Velocity, float Time) const;
+
+protected:
+
+	/** The movement the clients were last sent, the server compares it to the actual movement */
+	FVector LastSentLocation = FVector::ZeroVector;
+	FVector LastSentVelocity = FVector::ZeroVector;
+	float LastSentTime = -1.f;
+
+	/** Correction left to blend out on the client */
+	FVector RemainingCorrection = FVector::ZeroVector;
+	float CorrectionTimeLeft = 0.f;
 };
+
+DA_DECLARE_CLASS_REP_POLICY(ADAProjectile, Spatialize_Packed)
@@ -9,7 +9,7 @@ public class DARepGraphExample : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
-        PrivateDependencyModuleNames.AddRange(new string[] { "ReplicationGraph" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "ReplicationGraph", "DARepGraphTraceAnalysis" });
 
         bool bTargetConfig = Target.Configuration != UnrealTargetConfiguration.Shipping && Target.Configuration != UnrealTargetConfiguration.Test;
         if (Target.bBuildDeveloperTools || bTargetConfig)
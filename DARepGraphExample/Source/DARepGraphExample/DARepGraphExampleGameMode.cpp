@@ -2,6 +2,10 @@
 
 #include "DARepGraphExampleGameMode.h"
 #include "DACharacter.h"
+#include "DAFireQueue.h"
+#include "DAWallRegistry.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
 #include "UObject/ConstructorHelpers.h"
 
 ADARepGraphExampleGameMode::ADARepGraphExampleGameMode()
@@ -12,4 +16,33 @@ ADARepGraphExampleGameMode::ADARepGraphExampleGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	FireQueue = CreateDefaultSubobject<UDAFireQueue>(TEXT("FireQueue"));
+	WallRegistry = CreateDefaultSubobject<UDAWallRegistry>(TEXT("WallRegistry"));
+
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void ADARepGraphExampleGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Every shot requested since last frame is traced together, the projectiles spawn when the results come back next frame
+	FireQueue->Flush(GetWorld());
+}
+
+void ADARepGraphExampleGameMode::SetPlayerDefaults(APawn* PlayerPawn)
+{
+	Super::SetPlayerDefaults(PlayerPawn);
+
+	ADACharacter* Character = Cast<ADACharacter>(PlayerPawn);
+	APlayerState* PlayerState = Character != nullptr && Character->Controller != nullptr ? Character->Controller->PlayerState : nullptr;
+	if ((NumTeams <= 0) || (PlayerState == nullptr) || (GameState == nullptr))
+	{
+		return;
+	}
+
+	// Stable for a player as long as nobody ahead of it leaves, so respawned pawns keep their team
+	const int32 PlayerIndex = GameState->PlayerArray.IndexOfByKey(PlayerState);
+	Character->SetTeam((uint8)(FMath::Max(PlayerIndex, 0) % FMath::Min(NumTeams, (int32)ADACharacter::NoTeam)));
 }
@@ -13,6 +13,21 @@ class ADARepGraphExampleGameMode : public AGameModeBase
 
 public:
 	ADARepGraphExampleGameMode();
+
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
+
+	/** Batches the aim traces of server side fire requests */
+	UPROPERTY()
+	class UDAFireQueue* FireQueue;
+
+	/** Caps where and how often walls can be built */
+	UPROPERTY()
+	class UDAWallRegistry* WallRegistry;
+
+	/** Players are spread over this many teams in join order, 0 plays without teams */
+	UPROPERTY(config)
+	int32 NumTeams = 0;
 };
 
 
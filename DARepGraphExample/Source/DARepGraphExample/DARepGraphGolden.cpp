@@ -0,0 +1,437 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DARepGraphGolden.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ReplicationGraph.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+
+/** Differences logged before the rest are only counted */
+static const int32 MaxLoggedFailures = 20;
+
+void FDARepGraphGolden::StartRecord(const FString& Name, int32 NumFrames)
+{
+	Mode = EMode::Record;
+	GoldenName = Name;
+	NumFramesLeft = FMath::Max(NumFrames, 1);
+	bTaggedOnly = false;
+
+	Frames.Reset();
+	Golden = FRun();
+	NumCapturedConnections = 0;
+}
+
+bool FDARepGraphGolden::StartCompare(const FString& Name, int32 NumFrames, bool bInBudgetOnly, float InTimeTolerance, FOutputDevice& Ar)
+{
+	Mode = EMode::None;
+
+	if (Golden.Load(GetFilename(Name)) == false)
+	{
+		Ar.Logf(TEXT("Could not load golden file %s"), *GetFilename(Name));
+		return false;
+	}
+
+	Mode = EMode::Compare;
+	GoldenName = Name;
+	NumFramesLeft = NumFrames > 0 ? NumFrames : Golden.Frames.Num();
+	bBudgetOnly = bInBudgetOnly;
+	bTaggedOnly = false;
+	TimeTolerance = InTimeTolerance;
+
+	Frames.Reset();
+	NumCapturedConnections = 0;
+	return true;
+}
+
+void FDARepGraphGolden::StartCapture(int32 NumFrames, bool bInTaggedOnly)
+{
+	Mode = EMode::Capture;
+	NumFramesLeft = FMath::Max(NumFrames, 1);
+	bTaggedOnly = bInTaggedOnly;
+
+	Frames.Reset();
+	NumCapturedConnections = 0;
+}
+
+void FDARepGraphGolden::RecordConnectionGather(const FConnectionGatherActorListParameters& Params)
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	// The captured connections are kept between frames for their allocations
+	if (NumCapturedConnections == CapturedConnections.Num())
+	{
+		CapturedConnections.AddDefaulted();
+	}
+
+	FCapturedConnection& Captured = CapturedConnections[NumCapturedConnections++];
+	Captured.Connection = &Params.ConnectionManager;
+	Captured.Actors.Reset();
+
+	for (const FActorRepListConstView& List : Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default))
+	{
+		for (FActorRepListType Actor : List)
+		{
+			Captured.Actors.Add(Actor);
+		}
+	}
+}
+
+void FDARepGraphGolden::FinishFrame(double ReplicateSeconds)
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	FFrame& Frame = Frames.AddDefaulted_GetRef();
+	Frame.ReplicateSeconds = ReplicateSeconds;
+
+	for (int32 Idx = 0; Idx < NumCapturedConnections; ++Idx)
+	{
+		FCapturedConnection& Captured = CapturedConnections[Idx];
+
+		// An actor can be gathered by more than one node, the set is what matters. Actors sharing a key still count on their own
+		Captured.Actors.Sort();
+
+		FConnection& Connection = Frame.Connections.AddDefaulted_GetRef();
+		Connection.Name = GetConnectionName(*Captured.Connection);
+
+		for (int32 ActorIdx = 0; ActorIdx < Captured.Actors.Num(); ++ActorIdx)
+		{
+			if ((ActorIdx > 0) && (Captured.Actors[ActorIdx] == Captured.Actors[ActorIdx - 1]))
+			{
+				continue;
+			}
+
+			if ((bTaggedOnly == true) && (Captured.Actors[ActorIdx]->Tags.Num() == 0))
+			{
+				continue;
+			}
+
+			Connection.Actors.Add(GetActorKey(Captured.Actors[ActorIdx]));
+		}
+
+		Connection.Actors.Sort();
+	}
+
+	Frame.Connections.Sort([](const FConnection& A, const FConnection& B) { return A.Name < B.Name; });
+
+	NumCapturedConnections = 0;
+
+	if (--NumFramesLeft <= 0)
+	{
+		Finish();
+	}
+}
+
+FString FDARepGraphGolden::GetConnectionName(const UNetReplicationGraphConnection& Connection)
+{
+	UNetConnection* NetConnection = Connection.NetConnection;
+	if (NetConnection == nullptr)
+	{
+		return TEXT("None");
+	}
+
+	const AActor* Owner = NetConnection->PlayerController != nullptr ? NetConnection->PlayerController : NetConnection->OwningActor;
+	if ((Owner != nullptr) && (Owner->Tags.Num() > 0))
+	{
+		return Owner->Tags[0].ToString();
+	}
+
+	const APlayerState* PlayerState = NetConnection->PlayerController != nullptr ? NetConnection->PlayerController->PlayerState : nullptr;
+	return PlayerState != nullptr ? PlayerState->GetPlayerName() : NetConnection->LowLevelGetRemoteAddress();
+}
+
+FString FDARepGraphGolden::GetActorKey(const AActor* Actor)
+{
+	if (Actor->Tags.Num() > 0)
+	{
+		return Actor->Tags[0].ToString();
+	}
+
+	// Placed actors keep their name from the map, spawned ones are numbered in spawn order
+	return Actor->IsNetStartupActor() == true ? Actor->GetName() : Actor->GetClass()->GetName();
+}
+
+FString FDARepGraphGolden::GetFilename(const FString& Name)
+{
+	return FPaths::ProjectDir() / TEXT("Test") / TEXT("RepGraph") / (Name + TEXT(".txt"));
+}
+
+void FDARepGraphGolden::Finish()
+{
+	const EMode FinishedMode = Mode;
+	Mode = EMode::None;
+
+	if (FinishedMode == EMode::Record)
+	{
+		Golden.Frames = MoveTemp(Frames);
+
+		if (Golden.Save(GetFilename(GoldenName)) == true)
+		{
+			UE_LOG(LogNet, Display, TEXT("DAReplicationGraph: recorded %d frames to golden file %s"), Golden.Frames.Num(), *GetFilename(GoldenName));
+		}
+		else
+		{
+			UE_LOG(LogNet, Error, TEXT("DAReplicationGraph: could not save golden file %s"), *GetFilename(GoldenName));
+		}
+	}
+	else if (FinishedMode == EMode::Compare)
+	{
+		const int32 NumFailures = Compare(Frames, Golden, bBudgetOnly, TimeTolerance, [this](const FString& Failure)
+		{
+			UE_LOG(LogNet, Error, TEXT("DAReplicationGraph: golden %s: %s"), *GoldenName, *Failure);
+		});
+
+		if (NumFailures == 0)
+		{
+			UE_LOG(LogNet, Display, TEXT("DAReplicationGraph: golden %s PASSED over %d frames"), *GoldenName, Frames.Num());
+		}
+		else
+		{
+			UE_LOG(LogNet, Error, TEXT("DAReplicationGraph: golden %s FAILED with %d differences over %d frames"), *GoldenName, NumFailures, Frames.Num());
+		}
+	}
+
+	// Captured frames stay for the caller
+	if (FinishedMode != EMode::Capture)
+	{
+		Frames.Empty();
+	}
+
+	Golden = FRun();
+}
+
+int32 FDARepGraphGolden::Compare(const TArray<FFrame>& InFrames, const FRun& InGolden, bool bInBudgetOnly, float InTimeTolerance, TFunctionRef<void(const FString&)> OnFailure)
+{
+	int32 NumFailures = 0;
+
+	auto LogFailure = [&](const FString& Failure)
+	{
+		if (NumFailures++ < MaxLoggedFailures)
+		{
+			OnFailure(Failure);
+		}
+	};
+
+	auto JoinFirst = [](const TCHAR* Label, const TArray<FString>& Names)
+	{
+		if (Names.Num() == 0)
+		{
+			return FString();
+		}
+
+		const int32 NumShown = FMath::Min(Names.Num(), 5);
+
+		FString Joined = FString::Printf(TEXT(" %s %s"), Label, *Names[0]);
+		for (int32 Idx = 1; Idx < NumShown; ++Idx)
+		{
+			Joined += TEXT(", ") + Names[Idx];
+		}
+
+		return Names.Num() > NumShown ? Joined + FString::Printf(TEXT(" and %d more"), Names.Num() - NumShown) : Joined;
+	};
+
+	if (InFrames.Num() > InGolden.Frames.Num())
+	{
+		LogFailure(FString::Printf(TEXT("ran %d frames, the golden run only has %d"), InFrames.Num(), InGolden.Frames.Num()));
+	}
+
+	double Seconds = 0.0;
+	double GoldenSeconds = 0.0;
+
+	const int32 NumFrames = FMath::Min(InFrames.Num(), InGolden.Frames.Num());
+	for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+	{
+		const FFrame& Frame = InFrames[FrameIdx];
+		const FFrame& GoldenFrame = InGolden.Frames[FrameIdx];
+
+		Seconds += Frame.ReplicateSeconds;
+		GoldenSeconds += GoldenFrame.ReplicateSeconds;
+
+		for (const FConnection& GoldenConnection : GoldenFrame.Connections)
+		{
+			const FConnection* Connection = Frame.Connections.FindByPredicate([&](const FConnection& Candidate) { return Candidate.Name == GoldenConnection.Name; });
+			if (Connection == nullptr)
+			{
+				LogFailure(FString::Printf(TEXT("frame %d has no connection %s"), FrameIdx, *GoldenConnection.Name));
+				continue;
+			}
+
+			const TArray<FString>& Actors = Connection->Actors;
+			const TArray<FString>& GoldenActors = GoldenConnection.Actors;
+
+			if (bInBudgetOnly == true)
+			{
+				if (Actors.Num() > GoldenActors.Num())
+				{
+					LogFailure(FString::Printf(TEXT("frame %d connection %s gathered %d actors, budget %d"), FrameIdx, *Connection->Name, Actors.Num(), GoldenActors.Num()));
+				}
+				continue;
+			}
+
+			if (Actors == GoldenActors)
+			{
+				continue;
+			}
+
+			// Both are sorted, keys shared by several actors are matched one by one
+			TArray<FString> Extra;
+			TArray<FString> Missing;
+			int32 Idx = 0;
+			int32 GoldenIdx = 0;
+
+			while ((Idx < Actors.Num()) || (GoldenIdx < GoldenActors.Num()))
+			{
+				if ((GoldenIdx >= GoldenActors.Num()) || ((Idx < Actors.Num()) && (Actors[Idx] < GoldenActors[GoldenIdx])))
+				{
+					Extra.Add(Actors[Idx++]);
+				}
+				else if ((Idx >= Actors.Num()) || (GoldenActors[GoldenIdx] < Actors[Idx]))
+				{
+					Missing.Add(GoldenActors[GoldenIdx++]);
+				}
+				else
+				{
+					++Idx;
+					++GoldenIdx;
+				}
+			}
+
+			LogFailure(FString::Printf(TEXT("frame %d connection %s gathered%s%s"), FrameIdx, *Connection->Name, *JoinFirst(TEXT("extra"), Extra), *JoinFirst(TEXT("without"), Missing)));
+		}
+
+		for (const FConnection& Connection : Frame.Connections)
+		{
+			if (GoldenFrame.Connections.ContainsByPredicate([&](const FConnection& Candidate) { return Candidate.Name == Connection.Name; }) == false)
+			{
+				LogFailure(FString::Printf(TEXT("frame %d has connection %s the golden run does not have"), FrameIdx, *Connection.Name));
+			}
+		}
+	}
+
+	// Single frames are too noisy to compare, the whole run is held to the recorded time
+	if (NumFrames > 0)
+	{
+		const double AllowedSeconds = GoldenSeconds * InTimeTolerance;
+		if ((AllowedSeconds > 0.0) && (Seconds > AllowedSeconds))
+		{
+			LogFailure(FString::Printf(TEXT("replication took %.3f ms per frame, allowed %.3f ms"), Seconds * 1000.0 / NumFrames, AllowedSeconds * 1000.0 / NumFrames));
+		}
+	}
+
+	return NumFailures;
+}
+
+// --------------------------------------------------
+// FDARepGraphGolden::FRun
+
+bool FDARepGraphGolden::FRun::Load(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (FFileHelper::LoadFileToStringArray(Lines, *Filename) == false)
+	{
+		return false;
+	}
+
+	Frames.Reset();
+
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Tokens;
+		Line.ParseIntoArrayWS(Tokens);
+
+		if ((Tokens.Num() == 0) || (Tokens[0].StartsWith(TEXT("#")) == true))
+		{
+			continue;
+		}
+
+		if ((Tokens.Num() >= 2) && (Tokens[0] == TEXT("frame")))
+		{
+			Frames.AddDefaulted_GetRef().ReplicateSeconds = FCString::Atod(*Tokens[1]);
+		}
+		else if ((Tokens.Num() >= 2) && (Tokens[0] == TEXT("connection")) && (Frames.Num() > 0))
+		{
+			FConnection& Connection = Frames.Last().Connections.AddDefaulted_GetRef();
+			Connection.Name = Tokens[1];
+
+			for (int32 Idx = 2; Idx < Tokens.Num(); ++Idx)
+			{
+				// Key*Count stands for Count actors sharing a key
+				FString Key = Tokens[Idx];
+				FString Count;
+				const int32 Num = Tokens[Idx].Split(TEXT("*"), &Key, &Count, ESearchCase::CaseSensitive, ESearchDir::FromEnd) == true ? FCString::Atoi(*Count) : 1;
+
+				for (int32 Copy = 0; Copy < Num; ++Copy)
+				{
+					Connection.Actors.Add(Key);
+				}
+			}
+
+			Connection.Actors.Sort();
+		}
+	}
+
+	for (FFrame& Frame : Frames)
+	{
+		Frame.Connections.Sort([](const FConnection& A, const FConnection& B) { return A.Name < B.Name; });
+	}
+
+	return Frames.Num() > 0;
+}
+
+bool FDARepGraphGolden::FRun::Save(const FString& Filename) const
+{
+	// One line per connection and frame, so golden files diff well
+	FString Text;
+	for (const FFrame& Frame : Frames)
+	{
+		Text += FString::Printf(TEXT("frame %.9f\n"), Frame.ReplicateSeconds);
+
+		for (const FConnection& Connection : Frame.Connections)
+		{
+			Text += TEXT("connection ");
+			Text += Connection.Name;
+
+			for (int32 Idx = 0; Idx < Connection.Actors.Num(); )
+			{
+				int32 Num = 1;
+				while ((Idx + Num < Connection.Actors.Num()) && (Connection.Actors[Idx + Num] == Connection.Actors[Idx]))
+				{
+					++Num;
+				}
+
+				Text += TEXT(" ");
+				Text += Num > 1 ? FString::Printf(TEXT("%s*%d"), *Connection.Actors[Idx], Num) : Connection.Actors[Idx];
+				Idx += Num;
+			}
+
+			Text += TEXT("\n");
+		}
+	}
+
+	return FFileHelper::SaveStringToFile(Text, *Filename);
+}
@@ -0,0 +1,136 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraphTypes.h"
+
+class UNetReplicationGraphConnection;
+
+/**
+ * Records which actors every connection gathered over a number of frames and compares later runs against it
+ *
+ * Meant for scripted, deterministic scenarios: record a golden file once, then after a change to the graph run the
+ * same scenario and compare. Connections are matched by name and actors by key, see GetConnectionName and GetActorKey,
+ * so neither the order connections join in nor the order actors are spawned in matters. Besides the gathered sets the
+ * replication time is held to the recorded one times GoldenTimeTolerance, see DA.RepGraphGolden and the golden automation tests.
+ */
+class FDARepGraphGolden
+{
+public:
+
+	/** Actors one connection gathered in one frame */
+	struct FConnection
+	{
+		FString Name;
+
+		/** Sorted actor keys, an actor gathered by more than one node is only in here once */
+		TArray<FString> Actors;
+	};
+
+	struct FFrame
+	{
+		double ReplicateSeconds = 0.0;
+
+		/** Sorted by name */
+		TArray<FConnection> Connections;
+	};
+
+	/** Contents of a golden file */
+	struct FRun
+	{
+		TArray<FFrame> Frames;
+
+		bool Load(const FString& Filename);
+		bool Save(const FString& Filename) const;
+	};
+
+	/** Records the next NumFrames frames to the golden file Name */
+	void StartRecord(const FString& Name, int32 NumFrames);
+
+	/**
+	 * Compares the next frames against the golden file Name, as many frames as it holds when NumFrames is 0.
+	 * With bBudgetOnly the gathered sets may differ as long as no connection gathers more actors than in the golden run.
+	 */
+	bool StartCompare(const FString& Name, int32 NumFrames, bool bBudgetOnly, float TimeTolerance, FOutputDevice& Ar);
+
+	/** Keeps the next NumFrames frames for the caller, with bTaggedOnly actors without a tag are left out */
+	void StartCapture(int32 NumFrames, bool bTaggedOnly);
+
+	/** Frames of the last capture once it finished */
+	const TArray<FFrame>& GetCapturedFrames() const { return Frames; }
+
+	bool IsRunning() const { return Mode != EMode::None; }
+
+	void RecordConnectionGather(const FConnectionGatherActorListParameters& Params);
+
+	/** Ends the frame with the time the graph took to replicate it */
+	void FinishFrame(double ReplicateSeconds);
+
+	/**
+	 * Reports every difference of Frames to the golden run and returns their number. With bBudgetOnly only gathering more
+	 * actors than the golden run fails. The replication time is compared over all frames, single frames are too noisy.
+	 */
+	static int32 Compare(const TArray<FFrame>& InFrames, const FRun& InGolden, bool bInBudgetOnly, float InTimeTolerance, TFunctionRef<void(const FString&)> OnFailure);
+
+	/** The first tag of the connection's player controller, else its player name */
+	static FString GetConnectionName(const UNetReplicationGraphConnection& Connection);
+
+	/** The first tag of the actor, else the name of an actor placed in a level, else its class as spawned names depend on the spawn order */
+	static FString GetActorKey(const AActor* Actor);
+
+	/** Golden files live with the project so they can be submitted with the change they were recorded for */
+	static FString GetFilename(const FString& Name);
+
+protected:
+
+	enum class EMode : uint8
+	{
+		None,
+		Record,
+		Compare,
+		Capture
+	};
+
+	struct FCapturedConnection
+	{
+		const UNetReplicationGraphConnection* Connection;
+		TArray<FActorRepListType> Actors;
+	};
+
+	/** Saves the recording or logs the comparison */
+	void Finish();
+
+	EMode Mode = EMode::None;
+	FString GoldenName;
+	int32 NumFramesLeft = 0;
+
+	bool bBudgetOnly = false;
+	bool bTaggedOnly = false;
+	float TimeTolerance = 1.f;
+
+	TArray<FFrame> Frames;
+	FRun Golden;
+
+	/** Keys are only resolved once the frame is replicated, to keep the capture out of the measured time */
+	TArray<FCapturedConnection> CapturedConnections;
+	int32 NumCapturedConnections = 0;
+};
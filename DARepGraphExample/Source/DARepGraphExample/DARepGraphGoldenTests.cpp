@@ -0,0 +1,544 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "GameFramework/PlayerController.h"
+#include "DAReplicationGraph.h"
+#include "DARepGraphGolden.h"
+#include "DARepGraphTestTypes.h"
+#include "DAProjectile.h"
+#include "DABuildableWall.h"
+
+#if WITH_GAMEPLAY_DEBUGGER
+#include "GameplayDebuggerCategoryReplicator.h"
+#endif
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Golden tests of the replication graph
+ *
+ * Every scenario scripts connections and actors in a test world and captures, once the graph settled after each step,
+ * which tagged actors every connection gathered. The captures are compared against Test/RepGraph/<Scenario>.txt.
+ * Run with -DARepGraphRecordGoldens to write the captures to the golden files instead, then review and submit them.
+ * Golden files are only ever recorded, the replication times they hold are what a comparison allows times GoldenTimeTolerance.
+ */
+
+/** Frames replicated before a step is captured, enough for the cells nobody views to have been updated */
+static const int32 SettleFrames = 10;
+
+static const float TestDeltaSeconds = 1.f / 30.f;
+
+/** Viewer or actor of a scenario, the tag names it in the golden files */
+struct FDARepGraphTestActor
+{
+	FName Tag;
+	FVector Location;
+};
+
+/**
+ * A listen server world replicating through the DA replication graph to connections that drop what they are sent
+ *
+ * With bReverseOrder batches of connections and actors are added back to front, the gathered sets must not change.
+ */
+class FDARepGraphTestWorld
+{
+public:
+
+	explicit FDARepGraphTestWorld(bool bInReverseOrder);
+	~FDARepGraphTestWorld();
+
+	bool IsValid() const { return Graph != nullptr; }
+
+	UWorld* GetWorld() const { return World; }
+	UDAReplicationGraph* GetGraph() const { return Graph; }
+
+	/** Frames captured by CaptureStep */
+	const TArray<FDARepGraphGolden::FFrame>& GetFrames() const { return Frames; }
+
+	/** Adds a connection per viewer, viewing from a player controller without a pawn tagged with the connection name */
+	TArray<APlayerController*> AddConnections(const TArray<FDARepGraphTestActor>& Viewers);
+
+	template<typename ActorType>
+	TArray<ActorType*> Spawn(const TArray<FDARepGraphTestActor>& Actors, ULevel* Level = nullptr)
+	{
+		TArray<ActorType*> Spawned;
+		Spawned.SetNumZeroed(Actors.Num());
+
+		ForEachOrdered(Actors.Num(), [&](int32 Idx)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.OverrideLevel = Level;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+			Spawned[Idx] = World->SpawnActor<ActorType>(Actors[Idx].Location, FRotator::ZeroRotator, SpawnParams);
+			Spawned[Idx]->Tags.Add(Actors[Idx].Tag);
+		});
+
+		return Spawned;
+	}
+
+	/** A level streamed into the world, the connections only gather its actors once they report it visible */
+	ULevel* AddStreamingLevel();
+
+	/** What the server does when a client reports a streaming level loaded or unloaded */
+	void SetLevelVisible(APlayerController* PlayerController, ULevel* Level, bool bVisible);
+
+	/** Replicates until the graph caught up with the last changes, then captures the next frame */
+	void CaptureStep();
+
+	void ForEachOrdered(int32 Num, TFunctionRef<void(int32)> Func) const
+	{
+		for (int32 Step = 0; Step < Num; ++Step)
+		{
+			Func(bReverseOrder == true ? Num - 1 - Step : Step);
+		}
+	}
+
+protected:
+
+	bool bReverseOrder = false;
+
+	UWorld* World = nullptr;
+	UDARepGraphTestNetDriver* NetDriver = nullptr;
+	UDAReplicationGraph* Graph = nullptr;
+
+	TArray<ULevel*> StreamingLevels;
+	TArray<FDARepGraphGolden::FFrame> Frames;
+};
+
+FDARepGraphTestWorld::FDARepGraphTestWorld(bool bInReverseOrder)
+	: bReverseOrder(bInReverseOrder)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("DARepGraphTest"));
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+
+	// Registered like a net driver the engine created, so spawned and destroyed actors reach the graph
+	NetDriver = NewObject<UDARepGraphTestNetDriver>(GetTransientPackage());
+	NetDriver->SetNetDriverName(NAME_GameNetDriver);
+	WorldContext.ActiveNetDrivers.Add(FNamedNetDriver(NetDriver, nullptr));
+
+	NetDriver->SetWorld(World);
+	World->SetNetDriver(NetDriver);
+
+	FString Error;
+	if (NetDriver->InitListen(World, World->URL, false, Error) == false)
+	{
+		UE_LOG(LogNet, Error, TEXT("DARepGraphTest: could not listen: %s"), *Error);
+		return;
+	}
+
+	Graph = NewObject<UDAReplicationGraph>(GetTransientPackage());
+	NetDriver->SetReplicationDriver(Graph);
+}
+
+FDARepGraphTestWorld::~FDARepGraphTestWorld()
+{
+	for (ULevel* Level : StreamingLevels)
+	{
+		for (AActor* Actor : TArray<AActor*>(Level->Actors))
+		{
+			if (Actor != nullptr)
+			{
+				World->DestroyActor(Actor);
+			}
+		}
+
+		World->RemoveLevel(Level);
+	}
+
+	GEngine->ShutdownWorldNetDriver(World);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+TArray<APlayerController*> FDARepGraphTestWorld::AddConnections(const TArray<FDARepGraphTestActor>& Viewers)
+{
+	TArray<APlayerController*> PlayerControllers;
+	PlayerControllers.SetNumZeroed(Viewers.Num());
+
+	ForEachOrdered(Viewers.Num(), [&](int32 Idx)
+	{
+		UDARepGraphTestNetConnection* Connection = NewObject<UDARepGraphTestNetConnection>(NetDriver);
+		Connection->InitConnection(NetDriver, USOCK_Open, World->URL, 1000000);
+		Connection->ClientWorldPackageName = World->GetOutermost()->GetFName();
+		NetDriver->AddClientConnection(Connection);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		APlayerController* PlayerController = World->SpawnActor<APlayerController>(Viewers[Idx].Location, FRotator::ZeroRotator, SpawnParams);
+		PlayerController->Tags.Add(Viewers[Idx].Tag);
+
+		// Set up like UWorld::SpawnPlayActor does for a remote player. Out of the spectating state the server views
+		// from the controller itself instead of the location the client last sent
+		PlayerController->SetAutonomousProxy(true);
+		PlayerController->SetPlayer(Connection);
+		PlayerController->ChangeState(NAME_Playing);
+
+		PlayerControllers[Idx] = PlayerController;
+	});
+
+	return PlayerControllers;
+}
+
+ULevel* FDARepGraphTestWorld::AddStreamingLevel()
+{
+	// The graph keys streaming level actors by the package of their level
+	UPackage* Package = CreatePackage(nullptr, nullptr);
+
+	ULevel* Level = NewObject<ULevel>(Package, TEXT("PersistentLevel"));
+	Level->Initialize(FURL());
+	Level->OwningWorld = World;
+	Level->bIsVisible = true;
+
+	World->AddLevel(Level);
+	StreamingLevels.Add(Level);
+
+	return Level;
+}
+
+void FDARepGraphTestWorld::SetLevelVisible(APlayerController* PlayerController, ULevel* Level, bool bVisible)
+{
+	// APlayerController::ServerUpdateLevelVisibility would close the connection, the level has no package on disk
+	UNetConnection* Connection = PlayerController->NetConnection;
+	const FName LevelName = Level->GetOutermost()->GetFName();
+
+	if (bVisible == true)
+	{
+		Connection->ClientVisibleLevelNames.Add(LevelName);
+		Connection->GetReplicationConnectionDriver()->NotifyClientVisibleLevelNamesAdd(LevelName, World);
+	}
+	else
+	{
+		Connection->ClientVisibleLevelNames.Remove(LevelName);
+		Connection->GetReplicationConnectionDriver()->NotifyClientVisibleLevelNamesRemove(LevelName);
+	}
+}
+
+void FDARepGraphTestWorld::CaptureStep()
+{
+	for (int32 Frame = 0; Frame < SettleFrames; ++Frame)
+	{
+		Graph->ServerReplicateActors(TestDeltaSeconds);
+	}
+
+	// Only tagged actors, the actors the engine spawns with every world are not part of the scenario
+	FDARepGraphGolden& Golden = Graph->GetGolden();
+	Golden.StartCapture(1, true);
+	Graph->ServerReplicateActors(TestDeltaSeconds);
+
+	Frames.Append(Golden.GetCapturedFrames());
+}
+
+// --------------------------------------------------
+// Scenarios
+
+static const FVector ViewerA(0.f, 0.f, 0.f);
+static const FVector ViewerB(100000.f, 0.f, 0.f);
+
+/** Projectiles are gathered by the packed grid within their cull distance of the viewer, also when they move */
+static void RunProjectiles(FDARepGraphTestWorld& TestWorld)
+{
+	TestWorld.AddConnections({ { TEXT("A"), ViewerA }, { TEXT("B"), ViewerB } });
+
+	TArray<ADAProjectile*> Projectiles = TestWorld.Spawn<ADAProjectile>({
+		{ TEXT("ProjA_Near"), FVector(2000.f, 0.f, 0.f) },
+		{ TEXT("ProjA_Out"), FVector(5000.f, 0.f, 0.f) },
+		{ TEXT("ProjB_In"), FVector(98000.f, 0.f, 0.f) },
+		{ TEXT("ProjAB_Cross"), FVector(1000.f, 1000.f, 0.f) } });
+
+	ADAProjectile* ProjA_Out = Projectiles[1];
+	ADAProjectile* ProjAB_Cross = Projectiles[3];
+
+	TestWorld.CaptureStep();
+
+	// Leaves A for a cell nobody views
+	ProjA_Out->SetActorLocation(FVector(5000.f, 10000.f, 0.f));
+	ProjAB_Cross->SetActorLocation(FVector(50000.f, 0.f, 0.f));
+	TestWorld.CaptureStep();
+
+	// Just inside the cull distance of A, and in range of B
+	ProjA_Out->SetActorLocation(FVector(5000.f, 14000.f, 0.f));
+	ProjAB_Cross->SetActorLocation(FVector(95000.f, 0.f, 0.f));
+	TestWorld.CaptureStep();
+
+	// Just outside the cull distance of A
+	ProjA_Out->SetActorLocation(FVector(5000.f, 16000.f, 0.f));
+	ProjAB_Cross->SetActorLocation(FVector(100000.f, 14000.f, 0.f));
+	TestWorld.CaptureStep();
+}
+
+/** Walls are static in the grid node, only added and removed */
+static void RunWalls(FDARepGraphTestWorld& TestWorld)
+{
+	TestWorld.AddConnections({ { TEXT("A"), ViewerA }, { TEXT("B"), ViewerB } });
+
+	TArray<ADABuildableWall*> Walls = TestWorld.Spawn<ADABuildableWall>({
+		{ TEXT("WallA_1"), FVector(1000.f, 500.f, 0.f) },
+		{ TEXT("WallA_2"), FVector(-3000.f, 2000.f, 0.f) },
+		{ TEXT("WallB_1"), FVector(101000.f, 0.f, 0.f) },
+		{ TEXT("WallMid"), FVector(50000.f, 0.f, 0.f) } });
+
+	TestWorld.CaptureStep();
+
+	TestWorld.GetWorld()->DestroyActor(Walls[1]);
+	TestWorld.CaptureStep();
+
+	TestWorld.Spawn<ADABuildableWall>({ { TEXT("WallB_2"), FVector(99000.f, -3000.f, 0.f) } });
+	TestWorld.CaptureStep();
+}
+
+/** Always relevant actors of a streaming level are only gathered by the connections that have the level visible */
+static void RunStreamingLevel(FDARepGraphTestWorld& TestWorld)
+{
+	TArray<APlayerController*> PlayerControllers = TestWorld.AddConnections({ { TEXT("A"), ViewerA }, { TEXT("B"), ViewerB } });
+
+	ULevel* StreamingLevel = TestWorld.AddStreamingLevel();
+
+	TestWorld.Spawn<ADARepGraphTestAlwaysRelevantInfo>({ { TEXT("Info_Persistent"), FVector::ZeroVector } });
+	TestWorld.Spawn<ADARepGraphTestAlwaysRelevantInfo>({ { TEXT("Info_Sublevel"), FVector::ZeroVector } }, StreamingLevel);
+	TestWorld.CaptureStep();
+
+	TestWorld.SetLevelVisible(PlayerControllers[0], StreamingLevel, true);
+	TestWorld.CaptureStep();
+
+	TestWorld.SetLevelVisible(PlayerControllers[1], StreamingLevel, true);
+	TestWorld.SetLevelVisible(PlayerControllers[0], StreamingLevel, false);
+	TestWorld.CaptureStep();
+}
+
+#if WITH_GAMEPLAY_DEBUGGER
+/** A gameplay debugger replicator is only gathered by the connection of its owner, and no longer once it lost it */
+static void RunDebugger(FDARepGraphTestWorld& TestWorld)
+{
+	TArray<APlayerController*> PlayerControllers = TestWorld.AddConnections({ { TEXT("A"), ViewerA }, { TEXT("B"), ViewerB } });
+
+	TArray<AGameplayDebuggerCategoryReplicator*> Debuggers = TestWorld.Spawn<AGameplayDebuggerCategoryReplicator>({
+		{ TEXT("DebuggerA"), ViewerA },
+		{ TEXT("DebuggerB"), ViewerB } });
+
+	// As the gameplay debugger player manager sets them up
+	TestWorld.ForEachOrdered(Debuggers.Num(), [&](int32 Idx)
+	{
+		Debuggers[Idx]->DispatchBeginPlay();
+		Debuggers[Idx]->SetReplicatorOwner(PlayerControllers[Idx]);
+	});
+
+	TestWorld.CaptureStep();
+
+	Debuggers[0]->SetReplicatorOwner(nullptr);
+	TestWorld.CaptureStep();
+
+	Debuggers[0]->SetReplicatorOwner(PlayerControllers[0]);
+	TestWorld.CaptureStep();
+}
+#endif
+
+/** Many projectiles around both viewers, held to the recorded replication time and to the gathered counts */
+static void RunCrowd(FDARepGraphTestWorld& TestWorld)
+{
+	TestWorld.AddConnections({ { TEXT("A"), ViewerA }, { TEXT("B"), ViewerB } });
+
+	auto MakeRing = [](const FVector& Center, float Radius, int32 Num)
+	{
+		TArray<FDARepGraphTestActor> Ring;
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			const float Angle = 2.f * PI * Idx / Num;
+			Ring.Add({ TEXT("Crowd"), Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius });
+		}
+		return Ring;
+	};
+
+	TestWorld.Spawn<ADAProjectile>(MakeRing(ViewerA, 8000.f, 64));
+	TestWorld.Spawn<ADAProjectile>(MakeRing(ViewerB, 14000.f, 64));
+
+	// Out of the cull distance of both
+	TestWorld.Spawn<ADAProjectile>(MakeRing(ViewerA, 20000.f, 32));
+
+	TestWorld.CaptureStep();
+}
+
+struct FDARepGraphTestScenario
+{
+	const TCHAR* Name;
+	void (*Run)(FDARepGraphTestWorld& TestWorld);
+
+	/** Only fail on gathering more actors than the golden run, for scenarios meant to hold a budget */
+	bool bBudgetOnly;
+};
+
+static const FDARepGraphTestScenario Scenarios[] =
+{
+	{ TEXT("Projectiles"), &RunProjectiles, false },
+	{ TEXT("Walls"), &RunWalls, false },
+	{ TEXT("StreamingLevel"), &RunStreamingLevel, false },
+#if WITH_GAMEPLAY_DEBUGGER
+	{ TEXT("Debugger"), &RunDebugger, false },
+#endif
+	{ TEXT("Crowd"), &RunCrowd, true },
+};
+
+// --------------------------------------------------
+// Tests
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FDARepGraphGoldenTest, "DARepGraphExample.ReplicationGraph.Golden", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FDARepGraphGoldenTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const FDARepGraphTestScenario& Scenario : Scenarios)
+	{
+		OutBeautifiedNames.Add(Scenario.Name);
+		OutTestCommands.Add(Scenario.Name);
+	}
+}
+
+bool FDARepGraphGoldenTest::RunTest(const FString& Parameters)
+{
+	const FDARepGraphTestScenario* Scenario = nullptr;
+	for (const FDARepGraphTestScenario& Candidate : Scenarios)
+	{
+		if (Parameters == Candidate.Name)
+		{
+			Scenario = &Candidate;
+		}
+	}
+
+	if (Scenario == nullptr)
+	{
+		AddError(FString::Printf(TEXT("Unknown scenario %s"), *Parameters));
+		return false;
+	}
+
+	FDARepGraphTestWorld TestWorld(false);
+	if (TestWorld.IsValid() == false)
+	{
+		AddError(TEXT("Could not set up the test world"));
+		return false;
+	}
+
+	Scenario->Run(TestWorld);
+
+	const FString Filename = FDARepGraphGolden::GetFilename(Scenario->Name);
+
+	FDARepGraphGolden::FRun Golden;
+	const bool bLoaded = Golden.Load(Filename);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("DARepGraphRecordGoldens")) == true)
+	{
+		Golden.Frames = TestWorld.GetFrames();
+		if (Golden.Save(Filename) == false)
+		{
+			AddError(FString::Printf(TEXT("Could not save golden file %s"), *Filename));
+			return false;
+		}
+
+		AddWarning(FString::Printf(TEXT("Recorded golden file %s, review it before submitting"), *Filename));
+		return true;
+	}
+
+	if (bLoaded == false)
+	{
+		AddError(FString::Printf(TEXT("Could not load golden file %s, record it with -DARepGraphRecordGoldens"), *Filename));
+		return false;
+	}
+
+	// A golden file written by hand has no replication times to hold the run to
+	double GoldenSeconds = 0.0;
+	for (const FDARepGraphGolden::FFrame& Frame : Golden.Frames)
+	{
+		GoldenSeconds += Frame.ReplicateSeconds;
+	}
+
+	if (GoldenSeconds <= 0.0)
+	{
+		AddError(FString::Printf(TEXT("Golden file %s has no recorded replication time, record it with -DARepGraphRecordGoldens"), *Filename));
+		return false;
+	}
+
+	if (TestWorld.GetFrames().Num() != Golden.Frames.Num())
+	{
+		AddError(FString::Printf(TEXT("Captured %d frames, the golden run has %d"), TestWorld.GetFrames().Num(), Golden.Frames.Num()));
+	}
+
+	const int32 NumFailures = FDARepGraphGolden::Compare(TestWorld.GetFrames(), Golden, Scenario->bBudgetOnly, TestWorld.GetGraph()->GetGoldenTimeTolerance(), [this](const FString& Failure)
+	{
+		AddError(Failure);
+	});
+
+	return NumFailures == 0;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDARepGraphDeterminismTest, "DARepGraphExample.ReplicationGraph.Determinism", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDARepGraphDeterminismTest::RunTest(const FString& Parameters)
+{
+	// Connections joining and actors spawning in another order must gather the same sets
+	for (const FDARepGraphTestScenario& Scenario : Scenarios)
+	{
+		FDARepGraphGolden::FRun InOrder;
+		TArray<FDARepGraphGolden::FFrame> Reversed;
+
+		for (bool bReverseOrder : { false, true })
+		{
+			FDARepGraphTestWorld TestWorld(bReverseOrder);
+			if (TestWorld.IsValid() == false)
+			{
+				AddError(TEXT("Could not set up the test world"));
+				return false;
+			}
+
+			Scenario.Run(TestWorld);
+
+			(bReverseOrder == true ? Reversed : InOrder.Frames) = TestWorld.GetFrames();
+		}
+
+		// Only the gathered sets are compared, the replication times of two runs always differ
+		for (FDARepGraphGolden::FFrame& Frame : InOrder.Frames)
+		{
+			Frame.ReplicateSeconds = 0.0;
+		}
+
+		if (Reversed.Num() != InOrder.Frames.Num())
+		{
+			AddError(FString::Printf(TEXT("%s: captured %d frames in reverse order, %d in order"), Scenario.Name, Reversed.Num(), InOrder.Frames.Num()));
+		}
+
+		FDARepGraphGolden::Compare(Reversed, InOrder, false, 1.f, [&](const FString& Failure)
+		{
+			AddError(FString::Printf(TEXT("%s in reverse order: %s"), Scenario.Name, *Failure));
+		});
+	}
+
+	return true;
+}
+
+#endif
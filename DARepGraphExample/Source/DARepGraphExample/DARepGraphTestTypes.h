@@ -0,0 +1,77 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/Info.h"
+#include "DARepGraphTestTypes.generated.h"
+
+/**
+ * Net driver of the replication graph automation tests
+ *
+ * Never opens a socket, like the demo net driver. The tests add their connections and call the replication graph
+ * themselves, so the gathered sets only depend on the scripted scenario.
+ */
+UCLASS(Transient, NotPlaceable)
+class UDARepGraphTestNetDriver : public UNetDriver
+{
+	GENERATED_BODY()
+
+public:
+
+	// ~ begin UNetDriver implementation
+	virtual bool IsAvailable() const override { return true; }
+	virtual bool InitConnect(FNetworkNotify* InNotify, const FURL& ConnectURL, FString& Error) override;
+	virtual bool InitListen(FNetworkNotify* InNotify, FURL& ListenURL, bool bReuseAddressAndPort, FString& Error) override;
+	virtual FString LowLevelGetNetworkNumber() override { return FString(); }
+	virtual ISocketSubsystem* GetSocketSubsystem() override { return nullptr; }
+	virtual bool IsNetResourceValid() override { return true; }
+	// ~ end UNetDriver
+};
+
+/** Client connection of the replication graph automation tests, drops everything sent to it */
+UCLASS(Transient)
+class UDARepGraphTestNetConnection : public UNetConnection
+{
+	GENERATED_BODY()
+
+public:
+
+	// ~ begin UNetConnection implementation
+	virtual void LowLevelSend(void* Data, int32 CountBytes, int32 CountBits) override {}
+	virtual FString LowLevelGetRemoteAddress(bool bAppendPort = false) override { return GetName(); }
+	virtual FString LowLevelDescribe() override { return GetName(); }
+	virtual bool IsNetReady(bool Saturate) override { return true; }
+	// ~ end UNetConnection
+};
+
+/** An actor relevant to every connection, the level it is spawned in decides which connections gather it */
+UCLASS(NotPlaceable)
+class ADARepGraphTestAlwaysRelevantInfo : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+
+	ADARepGraphTestAlwaysRelevantInfo();
+};
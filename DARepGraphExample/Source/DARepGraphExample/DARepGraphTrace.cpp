@@ -0,0 +1,400 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DARepGraphTrace.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Engine/NetConnection.h"
+#include "ReplicationGraph.h"
+
+/** Frames the writer can fall behind before frames are dropped, plus the one slot the ring keeps free */
+static const uint32 TraceRingCapacity = 256;
+
+// --------------------------------------------------
+// FDARepGraphTraceWriter
+
+FDARepGraphTraceWriter::FDARepGraphTraceWriter(const FString& Filename)
+	: Ring(TraceRingCapacity)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	File = PlatformFile.OpenWrite(*Filename);
+	if (File == nullptr)
+	{
+		return;
+	}
+
+	uint32 Header[2] = { DARepGraphTraceMagic, DARepGraphTraceVersion };
+	File->Write((const uint8*)Header, sizeof(Header));
+
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("DARepGraphTraceWriter"), 0, TPri_BelowNormal);
+}
+
+FDARepGraphTraceWriter::~FDARepGraphTraceWriter()
+{
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+
+	if (WorkEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	}
+
+	// Whatever the thread did not get to, nothing is pushed anymore
+	if (File != nullptr)
+	{
+		WriteQueued();
+
+		TArray<uint8> EndRecord;
+		FMemoryWriter Ar(EndRecord);
+
+		uint8 Type = (uint8)EDARepGraphTraceRecord::End;
+		uint32 Dropped = (uint32)NumDropped.GetValue();
+		Ar << Type;
+		Ar.SerializeIntPacked(Dropped);
+
+		File->Write(EndRecord.GetData(), EndRecord.Num());
+		delete File;
+	}
+
+	TArray<uint8>* Buffer = nullptr;
+	while (Ring.Dequeue(Buffer) == true)
+	{
+		delete Buffer;
+	}
+}
+
+bool FDARepGraphTraceWriter::Push(TArray<uint8>* Buffer)
+{
+	if (Ring.Enqueue(Buffer) == true)
+	{
+		WorkEvent->Trigger();
+		return true;
+	}
+
+	NumDropped.Increment();
+	delete Buffer;
+	return false;
+}
+
+uint32 FDARepGraphTraceWriter::Run()
+{
+	while (bStopping == false)
+	{
+		WorkEvent->Wait();
+		WriteQueued();
+	}
+
+	WriteQueued();
+	return 0;
+}
+
+void FDARepGraphTraceWriter::Stop()
+{
+	bStopping = true;
+	WorkEvent->Trigger();
+}
+
+void FDARepGraphTraceWriter::WriteQueued()
+{
+	TArray<uint8>* Buffer = nullptr;
+	while (Ring.Dequeue(Buffer) == true)
+	{
+		File->Write(Buffer->GetData(), Buffer->Num());
+		delete Buffer;
+	}
+}
+
+// --------------------------------------------------
+// FDARepGraphTracer
+
+bool FDARepGraphTracer::Start(const FString& Filename, bool bInActorDetail, bool bInPositions)
+{
+	Stop();
+
+	Writer = MakeUnique<FDARepGraphTraceWriter>(Filename);
+	if (Writer->IsOpen() == false)
+	{
+		Writer.Reset();
+		return false;
+	}
+
+	bActorDetail = bInActorDetail;
+	bPositions = bInPositions;
+	return true;
+}
+
+void FDARepGraphTracer::Stop()
+{
+	PendingConnections.Reset();
+	NameIds.Reset();
+
+	delete FrameBuffer;
+	FrameBuffer = nullptr;
+
+	Writer.Reset();
+}
+
+void FDARepGraphTracer::RecordNodeGather(const UObject* Node, const FConnectionGatherActorListParameters& Params, int32 NumListsBefore)
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	const int32 NumLists = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+	if (NumLists > NumListsBefore)
+	{
+		FPendingConnection& Pending = GetPendingConnection(Params);
+		Pending.NodeLists.Add({ GetNameId(Node), NumListsBefore, NumLists });
+	}
+}
+
+void FDARepGraphTracer::RecordConnectionGather(const FConnectionGatherActorListParameters& Params, FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap)
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	FPendingConnection& Pending = GetPendingConnection(Params);
+	Pending.BitsBefore = GetBitsWritten(Pending.Connection);
+
+	// Lists added by nodes that do not report them, like the engine's actor list nodes
+	const uint32 OtherNodeId = GetNameId(nullptr);
+
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+	const FVector& ViewLocation = Params.Viewer.ViewLocation;
+
+	const TArray<FActorRepListConstView>& Lists = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default);
+	for (int32 ListIdx = 0; ListIdx < Lists.Num(); ++ListIdx)
+	{
+		const FNodeLists* NodeLists = Pending.NodeLists.FindByPredicate([&](const FNodeLists& InNodeLists) { return ListIdx >= InNodeLists.FirstList && ListIdx < InNodeLists.LastList; });
+		const uint32 NodeId = NodeLists != nullptr ? NodeLists->NodeId : OtherNodeId;
+
+		for (FActorRepListType Actor : Lists[ListIdx])
+		{
+			// The same test the graph does before replicating an actor, connection infos start out with the class settings
+			const FConnectionReplicationActorInfo* ConnectionActorInfo = ConnectionActorInfoMap.Find(Actor);
+			const float CullDistSq = ConnectionActorInfo != nullptr ? ConnectionActorInfo->CullDistanceSquared : GlobalActorReplicationInfoMap.Get(Actor).Settings.CullDistanceSquared;
+
+			const bool bCulled = (CullDistSq > 0.f) && ((Actor->GetActorLocation() - ViewLocation).SizeSquared() > CullDistSq);
+
+			FGatheredActor& Gathered = Pending.Actors.AddDefaulted_GetRef();
+			Gathered.Actor = Actor;
+			Gathered.ActorId = Actor->GetUniqueID();
+			Gathered.ClassId = GetNameId(Actor->GetClass());
+			Gathered.NodeId = NodeId;
+			Gathered.Flags = bCulled ? EDARepGraphTraceActorFlags::Culled : EDARepGraphTraceActorFlags::None;
+		}
+	}
+}
+
+void FDARepGraphTracer::FinishFrame(uint32 FrameNum)
+{
+	if ((IsRunning() == false) || ((PendingConnections.Num() == 0) && (FrameBuffer == nullptr)))
+	{
+		return;
+	}
+
+	FMemoryWriter Ar(GetFrameBuffer(), false, true);
+
+	for (FPendingConnection& Pending : PendingConnections)
+	{
+		TraceFrame.FrameNum = FrameNum;
+		TraceFrame.ConnectionId = Pending.Connection->NetConnection != nullptr ? Pending.Connection->NetConnection->GetUniqueID() : 0;
+		TraceFrame.Bits = (uint32)FMath::Max<int64>(GetBitsWritten(Pending.Connection) - Pending.BitsBefore, 0);
+		TraceFrame.Nodes.Reset();
+		TraceFrame.Classes.Reset();
+		TraceFrame.Actors.Reset();
+
+		auto FindOrAddCounts = [](TArray<FDARepGraphTraceFrame::FCounts>& CountsArray, uint32 Id) -> FDARepGraphTraceFrame::FCounts&
+		{
+			FDARepGraphTraceFrame::FCounts* Counts = CountsArray.FindByPredicate([Id](const FDARepGraphTraceFrame::FCounts& InCounts) { return InCounts.Id == Id; });
+			return Counts != nullptr ? *Counts : CountsArray.Add_GetRef({ Id, 0, 0, 0, 0 });
+		};
+
+		for (const FNodeLists& NodeLists : Pending.NodeLists)
+		{
+			FindOrAddCounts(TraceFrame.Nodes, NodeLists.NodeId).NumLists += NodeLists.LastList - NodeLists.FirstList;
+		}
+
+		for (FGatheredActor& Gathered : Pending.Actors)
+		{
+			const FConnectionReplicationActorInfo* ConnectionActorInfo = Pending.Connection->ActorInfoMap.Find(Gathered.Actor);
+			if ((ConnectionActorInfo != nullptr) && (ConnectionActorInfo->LastRepFrameNum == FrameNum))
+			{
+				Gathered.Flags |= EDARepGraphTraceActorFlags::Sent;
+			}
+
+			const bool bCulled = EnumHasAnyFlags(Gathered.Flags, EDARepGraphTraceActorFlags::Culled);
+			const bool bSent = EnumHasAnyFlags(Gathered.Flags, EDARepGraphTraceActorFlags::Sent);
+
+			for (FDARepGraphTraceFrame::FCounts* Counts : { &FindOrAddCounts(TraceFrame.Nodes, Gathered.NodeId), &FindOrAddCounts(TraceFrame.Classes, Gathered.ClassId) })
+			{
+				++Counts->Gathered;
+				Counts->Culled += bCulled ? 1 : 0;
+				Counts->Sent += bSent ? 1 : 0;
+			}
+
+			if (bActorDetail == true)
+			{
+				TraceFrame.Actors.Add({ Gathered.ActorId, Gathered.ClassId, Gathered.NodeId, (uint8)Gathered.Flags });
+			}
+		}
+
+		uint8 Type = (uint8)EDARepGraphTraceRecord::Frame;
+		Ar << Type;
+		TraceFrame.Serialize(Ar);
+	}
+
+	PendingConnections.Reset();
+
+	// The names written with a dropped frame are lost, write them again with the next frame
+	if (Writer->Push(FrameBuffer) == false)
+	{
+		NameIds.Reset();
+	}
+
+	FrameBuffer = nullptr;
+}
+
+void FDARepGraphTracer::RecordPositions(uint32 FrameNum, const TArray<UNetReplicationGraphConnection*>& Connections, FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap, TFunctionRef<EClassRepPolicy(const UClass*)> GetPolicy)
+{
+	if (IsRecordingPositions() == false)
+	{
+		return;
+	}
+
+	TracePositions.FrameNum = FrameNum;
+	TracePositions.Viewers.Reset();
+	TracePositions.Actors.Reset();
+
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		if (Connection->NetConnection != nullptr)
+		{
+			const FNetViewer Viewer(Connection->NetConnection, 0.f);
+			TracePositions.Viewers.Add({ Connection->NetConnection->GetUniqueID(), Viewer.ViewLocation });
+		}
+	}
+
+	for (auto It = GlobalActorReplicationInfoMap.CreateActorMapIterator(); It; ++It)
+	{
+		FActorRepListType Actor = It.Key();
+		if ((Actor == nullptr) || (Actor->IsPendingKill() == true))
+		{
+			continue;
+		}
+
+		EDARepGraphTraceGrid Grid;
+		switch (GetPolicy(Actor->GetClass()))
+		{
+		case EClassRepPolicy::Spatialize_Static:
+			Grid = EDARepGraphTraceGrid::Static;
+			break;
+
+		case EClassRepPolicy::Spatialize_Dynamic:
+		case EClassRepPolicy::Spatialize_Dormancy:
+			Grid = EDARepGraphTraceGrid::Dynamic;
+			break;
+
+		case EClassRepPolicy::Spatialize_Packed:
+		case EClassRepPolicy::Spatialize_Character:
+			Grid = EDARepGraphTraceGrid::Packed;
+			break;
+
+		default:
+			continue;
+		}
+
+		TracePositions.Actors.Add({ Actor->GetUniqueID(), GetNameId(Actor->GetClass()), Grid, GlobalActorReplicationInfoMap.Get(Actor).Settings.CullDistanceSquared, Actor->GetActorLocation() });
+	}
+
+	FMemoryWriter Ar(GetFrameBuffer(), false, true);
+
+	uint8 Type = (uint8)EDARepGraphTraceRecord::Positions;
+	Ar << Type;
+	TracePositions.Serialize(Ar);
+}
+
+FDARepGraphTracer::FPendingConnection& FDARepGraphTracer::GetPendingConnection(const FConnectionGatherActorListParameters& Params)
+{
+	UNetReplicationGraphConnection* Connection = &Params.ConnectionManager;
+
+	// A connection is gathered by all its nodes before the next one, it is nearly always the last one
+	if ((PendingConnections.Num() > 0) && (PendingConnections.Last().Connection == Connection))
+	{
+		return PendingConnections.Last();
+	}
+
+	FPendingConnection& Pending = PendingConnections.AddDefaulted_GetRef();
+	Pending.Connection = Connection;
+	return Pending;
+}
+
+uint32 FDARepGraphTracer::GetNameId(const UObject* Object)
+{
+	const TPair<uint32, FName> Key(Object != nullptr ? Object->GetUniqueID() : MAX_uint32, Object != nullptr ? Object->GetFName() : NAME_None);
+	if (const uint32* Id = NameIds.Find(Key))
+	{
+		return *Id;
+	}
+
+	uint32 Id = NameIds.Num() + 1;
+	NameIds.Add(Key, Id);
+
+	FMemoryWriter Ar(GetFrameBuffer(), false, true);
+
+	uint8 Type = (uint8)EDARepGraphTraceRecord::Name;
+	FString Name = Object != nullptr ? Object->GetName() : TEXT("Other");
+
+	Ar << Type;
+	Ar.SerializeIntPacked(Id);
+	Ar << Name;
+
+	return Id;
+}
+
+TArray<uint8>& FDARepGraphTracer::GetFrameBuffer()
+{
+	if (FrameBuffer == nullptr)
+	{
+		FrameBuffer = new TArray<uint8>();
+	}
+
+	return *FrameBuffer;
+}
+
+int64 FDARepGraphTracer::GetBitsWritten(const UNetReplicationGraphConnection* Connection)
+{
+	// Flushed packets plus what is still waiting in the send buffer
+	const UNetConnection* NetConnection = Connection->NetConnection;
+	return NetConnection != nullptr ? (int64)NetConnection->OutBytes * 8 + NetConnection->SendBuffer.GetNumBits() : 0;
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/CircularQueue.h"
+#include "ReplicationGraphTypes.h"
+#include "DARepGraphTraceFormat.h"
+#include "DAClassRepPolicy.h"
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+class UNetReplicationGraphConnection;
+
+/**
+ * Writes trace buffers to a file on its own thread
+ *
+ * The game thread hands over one buffer per frame through a lock free single producer / single consumer ring and never
+ * touches the file. When the writer falls behind and the ring is full, frames are dropped instead of stalling the server.
+ */
+class FDARepGraphTraceWriter : public FRunnable
+{
+public:
+
+	explicit FDARepGraphTraceWriter(const FString& Filename);
+	virtual ~FDARepGraphTraceWriter();
+
+	bool IsOpen() const { return File != nullptr; }
+
+	/** Takes ownership of the buffer, false if it was dropped */
+	bool Push(TArray<uint8>* Buffer);
+
+	int32 GetNumDropped() const { return NumDropped.GetValue(); }
+
+	// ~ begin FRunnable implementation
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// ~ end FRunnable
+
+protected:
+
+	void WriteQueued();
+
+	IFileHandle* File = nullptr;
+	FRunnableThread* Thread = nullptr;
+
+	TCircularQueue<TArray<uint8>*> Ring;
+
+	/** Triggered for every pushed buffer and on stop, the thread sleeps on it while the ring is empty */
+	FEvent* WorkEvent = nullptr;
+
+	FThreadSafeBool bStopping;
+	FThreadSafeCounter NumDropped;
+};
+
+/**
+ * Records why actors were or were not replicated, per frame and connection
+ *
+ * Nodes report the lists they added to a connection's gather, the last connection node reports the whole gather and
+ * which actors the cull distance check drops, and once the connections have been replicated the frame is finished
+ * with the actors that were sent and the bits written to each connection.
+ */
+class FDARepGraphTracer
+{
+public:
+
+	~FDARepGraphTracer() { Stop(); }
+
+	/**
+	 * Starts writing to Filename. With bActorDetail every gathered actor is written, otherwise only per class and node counts.
+	 * With bPositions the locations of the viewers and spatialized actors are written every frame for the grid simulator.
+	 */
+	bool Start(const FString& Filename, bool bActorDetail, bool bPositions);
+	void Stop();
+
+	bool IsRunning() const { return Writer.IsValid(); }
+	bool IsRecordingPositions() const { return IsRunning() && bPositions; }
+
+	/** Attributes the lists Node added to the gather after NumListsBefore */
+	void RecordNodeGather(const UObject* Node, const FConnectionGatherActorListParameters& Params, int32 NumListsBefore);
+
+	void RecordConnectionGather(const FConnectionGatherActorListParameters& Params, FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap);
+
+	void FinishFrame(uint32 FrameNum);
+
+	/** Records where the viewers of the connections and the spatialized network actors are */
+	void RecordPositions(uint32 FrameNum, const TArray<UNetReplicationGraphConnection*>& Connections, FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap, TFunctionRef<EClassRepPolicy(const UClass*)> GetPolicy);
+
+protected:
+
+	struct FNodeLists
+	{
+		uint32 NodeId;
+		int32 FirstList;
+		int32 LastList;
+	};
+
+	struct FGatheredActor
+	{
+		FActorRepListType Actor;
+		uint32 ActorId;
+		uint32 ClassId;
+		uint32 NodeId;
+		EDARepGraphTraceActorFlags Flags;
+	};
+
+	struct FPendingConnection
+	{
+		UNetReplicationGraphConnection* Connection = nullptr;
+		TArray<FNodeLists> NodeLists;
+		TArray<FGatheredActor> Actors;
+
+		/** Bits already written to the connection before it was replicated */
+		int64 BitsBefore = 0;
+	};
+
+	FPendingConnection& GetPendingConnection(const FConnectionGatherActorListParameters& Params);
+
+	/** Id of a class or node, the name record is written to the frame buffer on first use */
+	uint32 GetNameId(const UObject* Object);
+
+	static int64 GetBitsWritten(const UNetReplicationGraphConnection* Connection);
+
+	TArray<uint8>& GetFrameBuffer();
+
+	TUniquePtr<FDARepGraphTraceWriter> Writer;
+	bool bActorDetail = false;
+	bool bPositions = false;
+
+	/** Keyed by unique id and name rather than address, so an object that reuses the memory of a collected one is not given its name */
+	TMap<TPair<uint32, FName>, uint32> NameIds;
+	TArray<FPendingConnection> PendingConnections;
+
+	/** Buffer of the frame being recorded, handed to the writer when finished */
+	TArray<uint8>* FrameBuffer = nullptr;
+
+	/** Kept between frames for its allocations */
+	FDARepGraphTraceFrame TraceFrame;
+	FDARepGraphTracePositions TracePositions;
+};
@@ -0,0 +1,92 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DARepGraphTraceCommandlet.h"
+#include "HAL/FileManager.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Paths.h"
+#include "DARepGraphTraceFormat.h"
+#include "DARepGraphGridSim.h"
+
+UDARepGraphTraceCommandlet::UDARepGraphTraceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UDARepGraphTraceCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (FParse::Value(*Params, TEXT("file="), Filename) == false)
+	{
+		const FString TraceDir = FPaths::ProjectSavedDir() / TEXT("RepGraph");
+
+		TArray<FString> TraceFiles;
+		IFileManager::Get().FindFiles(TraceFiles, *(TraceDir / TEXT("*.dart")), true, false);
+
+		FDateTime NewestTime = FDateTime::MinValue();
+		for (const FString& TraceFile : TraceFiles)
+		{
+			const FDateTime TimeStamp = IFileManager::Get().GetTimeStamp(*(TraceDir / TraceFile));
+			if (TimeStamp > NewestTime)
+			{
+				NewestTime = TimeStamp;
+				Filename = TraceDir / TraceFile;
+			}
+		}
+
+		if (Filename.IsEmpty() == true)
+		{
+			UE_LOG(LogTemp, Error, TEXT("No trace in %s, pass one with -file="), *TraceDir);
+			return 1;
+		}
+	}
+
+	if (FParse::Param(*Params, TEXT("gridsim")) == true)
+	{
+		return RunGridSimulation(Filename, Params);
+	}
+
+	return FDARepGraphTraceAnalyzer::Analyze(Filename, *GLog) == true ? 0 : 1;
+}
+
+int32 UDARepGraphTraceCommandlet::RunGridSimulation(const FString& Filename, const FString& Params)
+{
+	FDAGridSimulator Simulator;
+	Simulator.bIncludePackedActors = FParse::Param(*Params, TEXT("allgrid"));
+
+	if (Simulator.Load(Filename, *GLog) == false)
+	{
+		return 1;
+	}
+
+	// The settings the trace was recorded with are the baseline of the sweep
+	const TCHAR* GraphSection = TEXT("/Script/DARepGraphExample.DAReplicationGraph");
+
+	FDAGridSimConfig Current;
+	GConfig->GetFloat(GraphSection, TEXT("GridCellSize"), Current.CellSize, GEngineIni);
+	GConfig->GetFloat(GraphSection, TEXT("SpatialBiasX"), Current.SpatialBias.X, GEngineIni);
+	GConfig->GetFloat(GraphSection, TEXT("SpatialBiasY"), Current.SpatialBias.Y, GEngineIni);
+
+	UE_LOG(LogTemp, Display, TEXT("Grid simulation of %s"), *Filename);
+	return Simulator.Sweep(Params, Current, *GLog) == true ? 0 : 1;
+}
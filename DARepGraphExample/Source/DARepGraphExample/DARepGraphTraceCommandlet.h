@@ -0,0 +1,55 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DARepGraphTraceCommandlet.generated.h"
+
+/**
+ * Summarizes a replication graph decision trace written by DA.RepGraphTrace
+ *
+ * -run=DARepGraphTrace [-file=<trace>], without a file the newest trace in Saved/RepGraph is used.
+ *
+ * With -gridsim a trace recorded with positions is replayed against other grid node settings instead:
+ * -cellsizes=5000,10000 -biases=X:Y,X:Y -cullscales=0.75,1 -insertcost=4 and -allgrid to also place the actors of the
+ * packed and character grids in the grid node. Cell sizes default to half, once and twice the configured cell size,
+ * biases to the configured one and one fitted to the recorded positions.
+ *
+ * Both also run without the editor in the DARepGraphTraceTool program.
+ */
+UCLASS()
+class UDARepGraphTraceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UDARepGraphTraceCommandlet();
+
+	// ~ begin UCommandlet implementation
+	virtual int32 Main(const FString& Params) override;
+	// ~ end UCommandlet
+
+protected:
+
+	int32 RunGridSimulation(const FString& Filename, const FString& Params);
+};
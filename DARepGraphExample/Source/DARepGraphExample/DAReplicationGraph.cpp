@@ -20,6 +20,21 @@
 
 #include "DAReplicationGraph.h"
 #include "Engine/LevelScriptActor.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/OutputDeviceNull.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "HAL/FileManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Engine/NetDriver.h"
+#include "Engine/DemoNetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectHash.h"
 
 #if WITH_GAMEPLAY_DEBUGGER
 #include "GameplayDebuggerCategoryReplicator.h"
@@ -30,11 +45,59 @@
 #include "DACharacter.h"
 #include "DAWeapon.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Network Actors"), STAT_DARepGraph_NetworkActors, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Actors"), STAT_DARepGraph_WeaponActors, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Open Actor Channels"), STAT_DARepGraph_ActorChannels, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("PackedGrid PrepareForReplication"), STAT_DAPackedGrid_PrepareForReplication, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("PackedGrid Gather"), STAT_DAPackedGrid_Gather, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PackedGrid Actors Tested"), STAT_DAPackedGrid_ActorsTested, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PackedGrid Actors Gathered"), STAT_DAPackedGrid_ActorsGathered, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PackedGrid Cells"), STAT_DAPackedGrid_Cells, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PackedGrid Overflow Actors"), STAT_DAPackedGrid_OverflowActors, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PackedGrid Unviewed Cells Skipped"), STAT_DAPackedGrid_CellsSkipped, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("ViewPriority Gather"), STAT_DAViewPriority_Gather, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("ViewPriority Actors In View"), STAT_DAViewPriority_InView, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("ViewPriority Actors Out Of View"), STAT_DAViewPriority_OutOfView, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RepList Pool Hits"), STAT_DARepList_PoolHits, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RepList Pool Misses"), STAT_DARepList_PoolMisses, STATGROUP_DAReplicationGraph);
+DECLARE_MEMORY_STAT(TEXT("RepList Preallocated Memory"), STAT_DARepList_PreallocatedMemory, STATGROUP_DAReplicationGraph);
+DECLARE_MEMORY_STAT(TEXT("Memory Global Actor Infos"), STAT_DARepGraphMemory_GlobalActorInfos, STATGROUP_DAReplicationGraph);
+DECLARE_MEMORY_STAT(TEXT("Memory Connection Actor Infos"), STAT_DARepGraphMemory_ConnectionActorInfos, STATGROUP_DAReplicationGraph);
+DECLARE_MEMORY_STAT(TEXT("Memory Nodes"), STAT_DARepGraphMemory_Nodes, STATGROUP_DAReplicationGraph);
+DECLARE_MEMORY_STAT(TEXT("Memory Streaming Level Lists"), STAT_DARepGraphMemory_StreamingLevelLists, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("DensityCull Gather"), STAT_DADensityCull_Gather, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("Team Gather"), STAT_DATeam_Gather, STATGROUP_DAReplicationGraph);
+DECLARE_CYCLE_STAT(TEXT("Spectator View Build"), STAT_DASpectator_Build, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spectator Views"), STAT_DASpectator_Views, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Team Members Out Of Range"), STAT_DATeam_OutOfRange, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("DensityCull Connections Over Budget"), STAT_DADensityCull_ConnectionsOverBudget, STATGROUP_DAReplicationGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("DensityCull Actors Culled"), STAT_DADensityCull_ActorsCulled, STATGROUP_DAReplicationGraph);
+
 void UDAReplicationGraph::ResetGameWorldState()
 {
 	Super::ResetGameWorldState();
+
+	// The world is going away, this is the end of the session for its map
+	SaveRepListProfile();
+
+	// Only world specific state is reset. The class rules and class infos, the rep list pool and the connection
+	// nodes are kept, so seamless travel does not redo the class scan or recreate the per connection graph
 	AlwaysRelevantStreamingLevelActors.Empty();
 
+	DensityCulledActors.Reset();
+
+	GridMovableActors.Reset();
+	GridOutOfBoundsActors.Reset();
+
+	for (TArray<FActorRepListType>& Bucket : GridCheckBuckets)
+	{
+		Bucket.Reset();
+	}
+
+	TeamMembers.Empty();
+	SpectatorViews.Empty();
+	SpectatorRemovedActors.Empty();
+
 	for (auto& ConnectionList : { Connections, PendingConnections })
 	{
 		for (UNetReplicationGraphConnection* Connection : ConnectionList)
@@ -58,12 +121,82 @@ void UDAReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnectio
 	ConnectionManager->OnClientVisibleLevelNameRemove.AddUObject(Node, &UDAReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove);
 
 	AddConnectionGraphNode(Node, ConnectionManager);
+
+	if (bUseSpectatorProfile == true)
+	{
+		AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_Spectator_ForConnection>(), ConnectionManager);
+	}
+
+	// Replay connections are spectators for their whole life, they never need the player nodes
+	const bool bReplayConnection = (ConnectionManager->NetConnection != nullptr) && (ConnectionManager->NetConnection->IsA<UDemoNetConnection>() == true);
+	if ((bUseSpectatorProfile == false) || (bReplayConnection == false))
+	{
+		// Added without density cull rules too, DA.ReloadRepPolicies can add rules to a running server
+		AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_DensityCull_ForConnection>(), ConnectionManager);
+
+		// Must be added after the gathering nodes, it works on what they gathered. The team node sets its own periods after it
+		if (bEnableViewPriority == true)
+		{
+			AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_ViewPriority_ForConnection>(), ConnectionManager);
+		}
+
+		if (bUseTeamRelevancy == true)
+		{
+			AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_Team_ForConnection>(), ConnectionManager);
+		}
+	}
+
+	if (bUseRepListProfile == true)
+	{
+		AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_RepListTelemetry_ForConnection>(), ConnectionManager);
+	}
+
+	// Always added and last, so a trace started later sees every connection and everything that was gathered
+	AddConnectionGraphNode(CreateNewNode<UDAReplicationGraphNode_Trace_ForConnection>(), ConnectionManager);
 }
 
 void UDAReplicationGraph::InitGlobalActorClassSettings()
 {
 	Super::InitGlobalActorClassSettings();
 
+	InitClassPolicies();
+	InitDensityCullClasses();
+
+	// -------------------------------
+	// Bind events here
+
+	ADACharacter::OnNewWeapon.AddUObject(this, &UDAReplicationGraph::OnCharacterNewWeapon);
+	ADACharacter::OnTeamChanged.AddUObject(this, &UDAReplicationGraph::OnCharacterTeamChanged);
+
+#if WITH_GAMEPLAY_DEBUGGER
+	AGameplayDebuggerCategoryReplicator::NotifyDebuggerOwnerChange.AddUObject(this, &UDAReplicationGraph::OnGameplayDebuggerOwnerChange);
+#endif
+}
+
+void UDAReplicationGraph::InitDensityCullClasses()
+{
+	DensityCullClasses.Reset();
+	for (const FDADensityCullRule& Rule : DensityCullRules)
+	{
+		UClass* RuleClass = Rule.ActorClass.TryLoadClass<AActor>();
+		if (RuleClass == nullptr)
+		{
+			continue;
+		}
+
+		FDADensityCullClass& DensityClass = DensityCullClasses.AddDefaulted_GetRef();
+		DensityClass.Class = RuleClass;
+		DensityClass.MaxActorsInRange = FMath::Max(Rule.MaxActorsInRange, 1);
+		DensityClass.MinCullDistanceSquared = FMath::Square(Rule.MinCullDistance);
+	}
+}
+
+void UDAReplicationGraph::InitClassPolicies()
+{
+	// Starts from scratch, class maps cache the policy of a parent class for its subclasses on lookup
+	ClassRepPolicies = TClassMap<EClassRepPolicy>();
+	NonSpatializedClasses.Reset();
+
 	// ----------------------------------------
 	// Assign mapping to classes
 
@@ -72,14 +205,203 @@ void UDAReplicationGraph::InitGlobalActorClassSettings()
 	SetRule(AReplicationGraphDebugActor::StaticClass(),				EClassRepPolicy::NotRouted);
 	SetRule(ALevelScriptActor::StaticClass(),						EClassRepPolicy::NotRouted);
 	SetRule(AInfo::StaticClass(),									EClassRepPolicy::RelevantAllConnections);
-	SetRule(ADAProjectile::StaticClass(),							EClassRepPolicy::Spatialize_Dynamic);
-	SetRule(ADABuildableWall::StaticClass(),						EClassRepPolicy::Spatialize_Static);
 
 #if WITH_GAMEPLAY_DEBUGGER
 	SetRule(AGameplayDebuggerCategoryReplicator::StaticClass(),		EClassRepPolicy::NotRouted);
 #endif
 
-	TArray<UClass*> ReplicatedClasses;
+	TArray<TPair<UClass*, EClassRepPolicy>> NativeRules;
+	GetNativeClassRules(NativeRules);
+
+	for (const TPair<UClass*, EClassRepPolicy>& NativeRule : NativeRules)
+	{
+		SetRule(NativeRule.Key, NativeRule.Value);
+	}
+
+	// Config rules come last so they can override the native ones
+	TArray<TPair<UClass*, const FDAClassPolicyRule*>> ConfigRules;
+	for (const FDAClassPolicyRule& Rule : ClassPolicyRules)
+	{
+		UClass* RuleClass = Rule.ActorClass.TryLoadClass<AActor>();
+		if (RuleClass == nullptr)
+		{
+			UE_LOG(LogNet, Warning, TEXT("DAReplicationGraph: class policy rule for unknown class %s"), *Rule.ActorClass.ToString());
+			continue;
+		}
+
+		ConfigRules.Emplace(RuleClass, &Rule);
+
+		if (Rule.bSetPolicy == true)
+		{
+			SetRule(RuleClass, Rule.Policy);
+		}
+	}
+
+	// Native classes are routed with their declared policy, unless a config rule replaced it for that exact class
+	NativeRoutePolicies.Reset();
+	for (const TPair<UClass*, EClassRepPolicy>& NativeRule : NativeRules)
+	{
+		EClassRepPolicy Policy = NativeRule.Value;
+		for (const TPair<UClass*, const FDAClassPolicyRule*>& ConfigRule : ConfigRules)
+		{
+			if ((ConfigRule.Key == NativeRule.Key) && (ConfigRule.Value->bSetPolicy == true))
+			{
+				Policy = ConfigRule.Value->Policy;
+			}
+		}
+
+		NativeRoutePolicies.Emplace(NativeRule.Key, Policy);
+	}
+
+	// The scan only depends on the class defaults, so it can be reused as long as the build and its content are the same
+	TArray<FDAScannedClass> ScannedClasses;
+
+	const FString ClassScanKey = GetClassScanCacheKey();
+	if ((ClassScanKey.IsEmpty() == true) || (LoadClassScanCache(ClassScanKey, ScannedClasses) == false))
+	{
+		ScanReplicatedClasses(ScannedClasses);
+
+		if (ClassScanKey.IsEmpty() == false)
+		{
+			SaveClassScanCache(ClassScanKey, ScannedClasses);
+		}
+	}
+
+	for (const FDAScannedClass& ScannedClass : ScannedClasses)
+	{
+		// if we already have mapped it to the policy, dont do it again
+		if ((ClassRepPolicies.Contains(ScannedClass.Class, false) == true) || (ScannedClass.bSameRelevancyAsSuper == true))
+		{
+			continue;
+		}
+
+		if (ScannedClass.bNonSpatialized == true)
+		{
+			NonSpatializedClasses.Add(ScannedClass.Class);
+		}
+
+		if (ScannedClass.bHasRule == true)
+		{
+			SetRule(ScannedClass.Class, ScannedClass.Rule);
+		}
+	}
+
+	// --------------------------------------
+	// Explicitly set replication info for our classes
+
+	TArray<TPair<UClass*, FClassReplicationInfo>> ExplicitClassInfos;
+
+	auto FindExplicitClassInfo = [&](UClass* InClass)
+	{
+		return ExplicitClassInfos.FindByPredicate([&](const TPair<UClass*, FClassReplicationInfo>& Pair) { return Pair.Key == InClass; });
+	};
+
+	auto SetClassInfo = [&](UClass* InClass, FClassReplicationInfo& RepInfo)
+	{
+		GlobalActorReplicationInfoMap.SetClassInfo(InClass, RepInfo);
+
+		TPair<UClass*, FClassReplicationInfo>* Existing = FindExplicitClassInfo(InClass);
+		if (Existing != nullptr)
+		{
+			Existing->Value = RepInfo;
+		}
+		else
+		{
+			ExplicitClassInfos.Emplace(InClass, RepInfo);
+		}
+	};
+
+	for (const TPair<UClass*, const FDAClassPolicyRule*>& ConfigRule : ConfigRules)
+	{
+		const FDAClassPolicyRule& Rule = *ConfigRule.Value;
+		if (Rule.HasClassInfo() == false)
+		{
+			continue;
+		}
+
+		FClassReplicationInfo RuleClassInfo;
+		InitClassReplicationInfo(RuleClassInfo, ConfigRule.Key, IsSpatialized(GetMappingPolicy(ConfigRule.Key)), NetDriver->NetServerMaxTickRate);
+
+		if (Rule.CullDistance > 0.f)
+		{
+			RuleClassInfo.CullDistanceSquared = FMath::Square(Rule.CullDistance);
+		}
+
+		if (Rule.ReplicationPeriodFrame > 0)
+		{
+			RuleClassInfo.ReplicationPeriodFrame = Rule.ReplicationPeriodFrame;
+		}
+
+		SetClassInfo(ConfigRule.Key, RuleClassInfo);
+	}
+
+	if (bUseWeaponReplicationTier == true)
+	{
+		FClassReplicationInfo WeaponClassInfo;
+		InitClassReplicationInfo(WeaponClassInfo, ADAWeapon::StaticClass(), true, NetDriver->NetServerMaxTickRate);
+		WeaponOwnerReplicationPeriodFrame = WeaponClassInfo.ReplicationPeriodFrame;
+
+		WeaponClassInfo.CullDistanceSquared = FMath::Square(WeaponCullDistance);
+		WeaponClassInfo.ReplicationPeriodFrame = WeaponOwnerReplicationPeriodFrame * FMath::Max(WeaponReplicationPeriodScale, 1);
+		SetClassInfo(ADAWeapon::StaticClass(), WeaponClassInfo);
+	}
+
+	if (GetDefault<ADAProjectile>()->bUseExtrapolation == true)
+	{
+		// Scales the period of a config rule for projectiles if there is one
+		FClassReplicationInfo ProjectileClassInfo;
+		if (const TPair<UClass*, FClassReplicationInfo>* RuleClassInfo = FindExplicitClassInfo(ADAProjectile::StaticClass()))
+		{
+			ProjectileClassInfo = RuleClassInfo->Value;
+		}
+		else
+		{
+			InitClassReplicationInfo(ProjectileClassInfo, ADAProjectile::StaticClass(), true, NetDriver->NetServerMaxTickRate);
+		}
+
+		ProjectileClassInfo.ReplicationPeriodFrame *= FMath::Max(ProjectileExtrapolationPeriodScale, 1);
+		SetClassInfo(ADAProjectile::StaticClass(), ProjectileClassInfo);
+	}
+
+	for (const FDAScannedClass& ScannedClass : ScannedClasses)
+	{
+		UClass* ReplicatedClass = ScannedClass.Class;
+
+		// Subclasses of explicitly set classes get the info of the closest one. It is set on every subclass rather than
+		// inherited on lookup, the lookup caches the inherited info and would keep it across DA.ReloadRepPolicies
+		const TPair<UClass*, FClassReplicationInfo>* ClosestExplicit = nullptr;
+		for (const TPair<UClass*, FClassReplicationInfo>& ExplicitClassInfo : ExplicitClassInfos)
+		{
+			if ((ReplicatedClass->IsChildOf(ExplicitClassInfo.Key) == true) && ((ClosestExplicit == nullptr) || (ExplicitClassInfo.Key->IsChildOf(ClosestExplicit->Key) == true)))
+			{
+				ClosestExplicit = &ExplicitClassInfo;
+			}
+		}
+
+		if (ClosestExplicit != nullptr)
+		{
+			if (ClosestExplicit->Key != ReplicatedClass)
+			{
+				GlobalActorReplicationInfoMap.SetClassInfo(ReplicatedClass, ClosestExplicit->Value);
+			}
+			continue;
+		}
+
+		bool bSptatilize = IsSpatialized(ClassRepPolicies.GetChecked(ReplicatedClass));
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, ScannedClass.NetCullDistanceSquared, ScannedClass.NetUpdateFrequency, bSptatilize, NetDriver->NetServerMaxTickRate);
+		GlobalActorReplicationInfoMap.SetClassInfo(ReplicatedClass, ClassInfo);
+	}
+}
+
+void UDAReplicationGraph::ScanReplicatedClasses(TArray<FDAScannedClass>& OutClasses) const
+{
+	auto ShouldSpatialize = [](const AActor* Actor)
+	{
+		return Actor->GetIsReplicated() && (!(Actor->bAlwaysRelevant || Actor->bOnlyRelevantToOwner || Actor->bNetUseOwnerRelevancy));
+	};
+
 	for (TObjectIterator<UClass> Itr; Itr; ++Itr)
 	{
 		UClass* Class = *Itr;
@@ -98,18 +420,10 @@ void UDAReplicationGraph::InitGlobalActorClassSettings()
 			continue;
 		}
 
-		ReplicatedClasses.Add(Class);
-
-		// if we already have mapped it to the policy, dont do it again
-		if (ClassRepPolicies.Contains(Class, false))
-		{
-			continue;
-		}
-
-		auto ShouldSpatialize = [](const AActor* Actor)
-		{
-			return Actor->GetIsReplicated() && (!(Actor->bAlwaysRelevant || Actor->bOnlyRelevantToOwner || Actor->bNetUseOwnerRelevancy));
-		};
+		FDAScannedClass& ScannedClass = OutClasses.AddDefaulted_GetRef();
+		ScannedClass.Class = Class;
+		ScannedClass.NetCullDistanceSquared = ActorCDO->NetCullDistanceSquared;
+		ScannedClass.NetUpdateFrequency = ActorCDO->NetUpdateFrequency;
 
 		UClass* SuperClass = Class->GetSuperClass();
 		if (AActor* SuperCDO = Cast<AActor>(SuperClass->GetDefaultObject()))
@@ -119,75 +433,196 @@ void UDAReplicationGraph::InitGlobalActorClassSettings()
 				&& SuperCDO->bOnlyRelevantToOwner == ActorCDO->bOnlyRelevantToOwner
 				&& SuperCDO->bNetUseOwnerRelevancy == ActorCDO->bNetUseOwnerRelevancy)
 			{
+				ScannedClass.bSameRelevancyAsSuper = true;
 				continue;
 			}
 
-			if (ShouldSpatialize(ActorCDO) == false && ShouldSpatialize(SuperCDO) == true)
-			{
-				NonSpatializedClasses.Add(Class);
-			}
+			ScannedClass.bNonSpatialized = (ShouldSpatialize(ActorCDO) == false) && (ShouldSpatialize(SuperCDO) == true);
 		}
 
 		if (ShouldSpatialize(ActorCDO) == true)
 		{
-			SetRule(Class, EClassRepPolicy::Spatialize_Dynamic);
+			ScannedClass.bHasRule = true;
+			ScannedClass.Rule = EClassRepPolicy::Spatialize_Dynamic;
 		}
 		else if (ActorCDO->bAlwaysRelevant && !ActorCDO->bOnlyRelevantToOwner)
 		{
-			SetRule(Class, EClassRepPolicy::RelevantAllConnections);
+			ScannedClass.bHasRule = true;
+			ScannedClass.Rule = EClassRepPolicy::RelevantAllConnections;
 		}
 	}
+}
+
+FString UDAReplicationGraph::GetClassScanCacheKey() const
+{
+	if ((bUseClassScanCache == false) || (FPlatformProperties::RequiresCookedData() == false))
+	{
+		return FString();
+	}
 
-	// --------------------------------------
-	// Explicitly set replication info for our classes
+	// Bump when the class scan or the cache layout changes
+	static const int32 CacheVersion = 1;
 
-	TArray<UClass*> ExplicitlySetClasses;
+	// The binary the native class defaults come from
+	IFileManager& FileManager = IFileManager::Get();
+	FString Key = FString::Printf(TEXT("%d|%s|%s|%s"), CacheVersion, *FEngineVersion::Current().ToString(), *FApp::GetBuildDate(),
+		*FileManager.GetTimeStamp(FPlatformProcess::ExecutablePath()).ToString());
 
-	auto SetClassInfo = [&](UClass* InClass, FClassReplicationInfo& RepInfo)
+	// The cooked content the blueprint class defaults come from
+	const FString PakDir = FPaths::ProjectContentDir() / TEXT("Paks");
+
+	TArray<FString> PakFiles;
+	FileManager.FindFiles(PakFiles, *(PakDir / TEXT("*.pak")), true, false);
+	PakFiles.Sort();
+
+	for (const FString& PakFile : PakFiles)
 	{
-		GlobalActorReplicationInfoMap.SetClassInfo(InClass, RepInfo);
-		ExplicitlySetClasses.Add(InClass);
-	};
+		const FString PakPath = PakDir / PakFile;
+		Key += FString::Printf(TEXT("|%s:%lld:%s"), *PakFile, FileManager.FileSize(*PakPath), *FileManager.GetTimeStamp(*PakPath).ToString());
+	}
 
-	FClassReplicationInfo PawnClassInfo;
-	PawnClassInfo.CullDistanceSquared = 300000.f * 300000.f;
-	SetClassInfo(APawn::StaticClass(), PawnClassInfo);
+	// The loaded actor classes, hashed by name only so no class default is touched. Summed rather than chained,
+	// the iteration order depends on the load order
+	uint32 NumActorClasses = 0;
+	uint32 NameHashSum = 0;
+	uint32 NameHashXor = 0;
 
-	for (UClass* ReplicatedClass : ReplicatedClasses)
+	FString Name;
+	for (TObjectIterator<UClass> Itr; Itr; ++Itr)
 	{
-		if (ExplicitlySetClasses.FindByPredicate([&](const UClass* InClass) { return ReplicatedClass->IsChildOf(InClass); }) != nullptr)
+		if (Itr->IsChildOf(AActor::StaticClass()) == false)
 		{
 			continue;
 		}
 
-		bool bSptatilize = IsSpatialized(ClassRepPolicies.GetChecked(ReplicatedClass));
+		Itr->GetOutermost()->GetFName().ToString(Name);
+		uint32 NameHash = FCrc::StrCrc32(*Name);
 
-		FClassReplicationInfo ClassInfo;
-		InitClassReplicationInfo(ClassInfo, ReplicatedClass, bSptatilize, NetDriver->NetServerMaxTickRate);
-		GlobalActorReplicationInfoMap.SetClassInfo(ReplicatedClass, ClassInfo);
+		Itr->GetFName().ToString(Name);
+		NameHash = FCrc::StrCrc32(*Name, NameHash);
+
+		++NumActorClasses;
+		NameHashSum += NameHash;
+		NameHashXor ^= NameHash;
 	}
 
-	// -------------------------------
-	// Bind events here
+	Key += FString::Printf(TEXT("|%u:%08x:%08x"), NumActorClasses, NameHashSum, NameHashXor);
 
-	ADACharacter::OnNewWeapon.AddUObject(this, &UDAReplicationGraph::OnCharacterNewWeapon);
+	return Key;
+}
 
-#if WITH_GAMEPLAY_DEBUGGER
-	AGameplayDebuggerCategoryReplicator::NotifyDebuggerOwnerChange.AddUObject(this, &UDAReplicationGraph::OnGameplayDebuggerOwnerChange);
-#endif
+FString UDAReplicationGraph::GetClassScanCacheFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("RepGraph") / TEXT("ClassScanCache.bin");
+}
+
+bool UDAReplicationGraph::LoadClassScanCache(const FString& Key, TArray<FDAScannedClass>& OutClasses) const
+{
+	TArray<uint8> Data;
+	if (FFileHelper::LoadFileToArray(Data, *GetClassScanCacheFilename(), FILEREAD_Silent) == false)
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+
+	FString SavedKey;
+	int32 NumClasses = 0;
+	Reader << SavedKey;
+	Reader << NumClasses;
+
+	if ((Reader.IsError() == true) || (SavedKey != Key) || (NumClasses < 0))
+	{
+		return false;
+	}
+
+	OutClasses.Reserve(NumClasses);
+
+	for (int32 Idx = 0; (Idx < NumClasses) && (Reader.IsError() == false); ++Idx)
+	{
+		FString ClassPath;
+		uint8 Flags = 0;
+		uint8 Rule = 0;
+
+		FDAScannedClass& ScannedClass = OutClasses.AddDefaulted_GetRef();
+		Reader << ClassPath;
+		Reader << Flags;
+		Reader << Rule;
+		Reader << ScannedClass.NetCullDistanceSquared;
+		Reader << ScannedClass.NetUpdateFrequency;
+
+		// The key covers the loaded actor classes, so every cached class is expected to be loaded
+		ScannedClass.Class = FindObject<UClass>(nullptr, *ClassPath);
+		if (ScannedClass.Class == nullptr)
+		{
+			OutClasses.Reset();
+			return false;
+		}
+
+		ScannedClass.bSameRelevancyAsSuper = (Flags & 1) != 0;
+		ScannedClass.bNonSpatialized = (Flags & 2) != 0;
+		ScannedClass.bHasRule = (Flags & 4) != 0;
+		ScannedClass.Rule = (EClassRepPolicy)Rule;
+	}
+
+	if (Reader.IsError() == true)
+	{
+		OutClasses.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void UDAReplicationGraph::SaveClassScanCache(const FString& Key, const TArray<FDAScannedClass>& Classes) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	FString SavedKey = Key;
+	int32 NumClasses = Classes.Num();
+	Writer << SavedKey;
+	Writer << NumClasses;
+
+	for (const FDAScannedClass& ScannedClass : Classes)
+	{
+		FString ClassPath = ScannedClass.Class->GetPathName();
+		uint8 Flags = (uint8)((ScannedClass.bSameRelevancyAsSuper << 0) | (ScannedClass.bNonSpatialized << 1) | (ScannedClass.bHasRule << 2));
+		uint8 Rule = (uint8)ScannedClass.Rule;
+		float NetCullDistanceSquared = ScannedClass.NetCullDistanceSquared;
+		float NetUpdateFrequency = ScannedClass.NetUpdateFrequency;
+
+		Writer << ClassPath;
+		Writer << Flags;
+		Writer << Rule;
+		Writer << NetCullDistanceSquared;
+		Writer << NetUpdateFrequency;
+	}
+
+	FFileHelper::SaveArrayToFile(Data, *GetClassScanCacheFilename());
+}
+
+void UDAReplicationGraph::GetNativeClassRules(TArray<TPair<UClass*, EClassRepPolicy>>& OutRules) const
+{
+	AddNativeClassRule<ADACharacter>(OutRules);
+	AddNativeClassRule<ADAProjectile>(OutRules);
+	AddNativeClassRule<ADABuildableWall>(OutRules);
+
+	// Without the tier weapons keep the policy the class scan gives them and are routed through the class map
+	if (bUseWeaponReplicationTier == true)
+	{
+		AddNativeClassRule<ADAWeapon>(OutRules);
+	}
 }
 
 void UDAReplicationGraph::InitGlobalGraphNodes()
 {
-	PreAllocateRepList(3, 12);
-	PreAllocateRepList(6, 12);
-	PreAllocateRepList(128, 64);
-	PreAllocateRepList(512, 16);
+	PreAllocateRepListsFromProfile(NetDriver != nullptr ? NetDriver->GetWorld() : nullptr);
 
 
 	// ---------------------------------
 	// Create our grid node
-	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode = CreateNewNode<UDAReplicationGraphNode_GridSpatialization2D>();
 	GridNode->CellSize = GridCellSize;
 	GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
 
@@ -198,6 +633,34 @@ void UDAReplicationGraph::InitGlobalGraphNodes()
 
 	AddGlobalGraphNode(GridNode);
 
+	// ---------------------------------
+	// Create our packed grid node
+	if (bUsePackedGrid == true)
+	{
+		PackedGridNode = CreateNewNode<UDAReplicationGraphNode_PackedGrid>();
+		PackedGridNode->CellSize = PackedGridCellSize;
+		PackedGridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+		PackedGridNode->MaxNewCellsPerFrame = PackedGridMaxNewCellsPerFrame;
+		PackedGridNode->MaxCellsPerAxis = PackedGridMaxCellsPerAxis;
+		PackedGridNode->UnviewedCellUpdatePeriod = PackedGridUnviewedCellUpdatePeriod;
+
+		AddGlobalGraphNode(PackedGridNode);
+	}
+
+	// ---------------------------------
+	// Create our character grid node
+	if (bUseCharacterGrid == true)
+	{
+		CharacterGridNode = CreateNewNode<UDAReplicationGraphNode_PackedGrid>();
+		CharacterGridNode->CellSize = CharacterGridCellSize;
+		CharacterGridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+		CharacterGridNode->MaxNewCellsPerFrame = PackedGridMaxNewCellsPerFrame;
+		CharacterGridNode->MaxCellsPerAxis = PackedGridMaxCellsPerAxis;
+		CharacterGridNode->UnviewedCellUpdatePeriod = CharacterGridUnviewedCellUpdatePeriod;
+
+		AddGlobalGraphNode(CharacterGridNode);
+	}
+
 	// ---------------------------------
 	// Create our always relevant node
 	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
@@ -206,39 +669,108 @@ void UDAReplicationGraph::InitGlobalGraphNodes()
 
 void UDAReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
 {
-	EClassRepPolicy MappingPolicy = GetMappingPolicy(ActorInfo.Class);
-	switch (MappingPolicy)
-	{
-	case EClassRepPolicy::RelevantAllConnections:
+	AddActorToPolicyNodes(ActorInfo, GlobalInfo, GetRoutePolicy(ActorInfo.Class));
+
+	if (FDADensityCullClass* DensityClass = FindDensityCullClass(ActorInfo.Class))
 	{
-		if (ActorInfo.StreamingLevelName == NAME_None)
-		{
-			AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
-		}
-		else
-		{
-			FActorRepListRefView& RepList = AlwaysRelevantStreamingLevelActors.FindOrAdd(ActorInfo.StreamingLevelName);
-			RepList.PrepareForWrite();
-			RepList.ConditionalAdd(ActorInfo.Actor);
-		}
-		break;
+		DensityCulledActors.Add(ActorInfo.Actor, (int32)(DensityClass - DensityCullClasses.GetData()));
 	}
 
-	case EClassRepPolicy::Spatialize_Static:
+	if (ActorInfo.Class->IsChildOf(ADAWeapon::StaticClass()))
 	{
-		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
-		break;
+		INC_DWORD_STAT(STAT_DARepGraph_WeaponActors);
 	}
 
-	case EClassRepPolicy::Spatialize_Dynamic:
+	// Pawns usually get their team after they have been routed, OnCharacterTeamChanged picks those up
+	if (ADACharacter* Character = Cast<ADACharacter>(ActorInfo.Actor))
 	{
-		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		AddTeamMember(Character, Character->GetTeam());
+	}
+}
+
+void UDAReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	RemoveActorFromPolicyNodes(ActorInfo, GetRoutePolicy(ActorInfo.Class));
+
+	DensityCulledActors.Remove(ActorInfo.Actor);
+
+	if (ActorInfo.Class->IsChildOf(ADAWeapon::StaticClass()))
+	{
+		DEC_DWORD_STAT(STAT_DARepGraph_WeaponActors);
+	}
+
+	if (ADACharacter* Character = Cast<ADACharacter>(ActorInfo.Actor))
+	{
+		RemoveTeamMember(Character, Character->GetTeam());
+	}
+
+	// The shared spectator lists are only rebuilt every few frames, a view drops removed actors when it is next used
+	if (SpectatorViews.Num() > 0)
+	{
+		SpectatorRemovedActors.Add(ActorInfo.Actor);
+	}
+}
+
+void UDAReplicationGraph::AddActorToPolicyNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepPolicy MappingPolicy)
+{
+	switch (MappingPolicy)
+	{
+	case EClassRepPolicy::RelevantAllConnections:
+	{
+		if (ActorInfo.StreamingLevelName == NAME_None)
+		{
+			AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		else
+		{
+			FActorRepListRefView& RepList = AlwaysRelevantStreamingLevelActors.FindOrAdd(ActorInfo.StreamingLevelName);
+			RepList.PrepareForWrite();
+			RepList.ConditionalAdd(ActorInfo.Actor);
+		}
+		break;
+	}
+
+	case EClassRepPolicy::Spatialize_Static:
+	{
+		AddActorToGrid(ActorInfo, GlobalInfo, MappingPolicy);
+		break;
+	}
+
+	case EClassRepPolicy::Spatialize_Dynamic:
+	{
+		AddActorToGrid(ActorInfo, GlobalInfo, MappingPolicy);
 		break;
 	}
 
 	case EClassRepPolicy::Spatialize_Dormancy:
 	{
-		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		AddActorToGrid(ActorInfo, GlobalInfo, MappingPolicy);
+		break;
+	}
+
+	case EClassRepPolicy::Spatialize_Packed:
+	{
+		if (PackedGridNode != nullptr)
+		{
+			PackedGridNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		else
+		{
+			AddActorToGrid(ActorInfo, GlobalInfo, EClassRepPolicy::Spatialize_Dynamic);
+		}
+		break;
+	}
+
+	case EClassRepPolicy::Spatialize_Character:
+	{
+		if (CharacterGridNode != nullptr)
+		{
+			CharacterGridNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		else
+		{
+			AddActorToGrid(ActorInfo, GlobalInfo, EClassRepPolicy::Spatialize_Dynamic);
+		}
 		break;
 	}
 
@@ -249,9 +781,8 @@ void UDAReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorI
 	}
 }
 
-void UDAReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+void UDAReplicationGraph::RemoveActorFromPolicyNodes(const FNewReplicatedActorInfo& ActorInfo, EClassRepPolicy MappingPolicy)
 {
-	EClassRepPolicy MappingPolicy = GetMappingPolicy(ActorInfo.Class);
 	switch (MappingPolicy)
 	{
 	case EClassRepPolicy::RelevantAllConnections:
@@ -270,173 +801,2262 @@ void UDAReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedAct
 
 	case EClassRepPolicy::Spatialize_Static:
 	{
-		GridNode->RemoveActor_Static(ActorInfo);
+		RemoveActorFromGrid(ActorInfo, MappingPolicy);
 		break;
 	}
 
 	case EClassRepPolicy::Spatialize_Dynamic:
 	{
-		GridNode->RemoveActor_Dynamic(ActorInfo);
+		RemoveActorFromGrid(ActorInfo, MappingPolicy);
 		break;
 	}
 
 	case EClassRepPolicy::Spatialize_Dormancy:
 	{
-		GridNode->RemoveActor_Dormancy(ActorInfo);
+		RemoveActorFromGrid(ActorInfo, MappingPolicy);
 		break;
 	}
 
-	default:
+	case EClassRepPolicy::Spatialize_Packed:
 	{
+		if (PackedGridNode != nullptr)
+		{
+			PackedGridNode->NotifyRemoveNetworkActor(ActorInfo);
+		}
+		else
+		{
+			RemoveActorFromGrid(ActorInfo, EClassRepPolicy::Spatialize_Dynamic);
+		}
 		break;
 	}
-	}
-}
 
-void UDAReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* InClass, bool bSpatilize, float ServerMaxTickRate)
-{
-	if (AActor* CDO = Cast<AActor>(InClass->GetDefaultObject()))
+	case EClassRepPolicy::Spatialize_Character:
 	{
-		if (bSpatilize == true)
+		if (CharacterGridNode != nullptr)
 		{
-			Info.CullDistanceSquared = CDO->NetCullDistanceSquared;
+			CharacterGridNode->NotifyRemoveNetworkActor(ActorInfo);
 		}
+		else
+		{
+			RemoveActorFromGrid(ActorInfo, EClassRepPolicy::Spatialize_Dynamic);
+		}
+		break;
+	}
 
-		Info.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ServerMaxTickRate / CDO->NetUpdateFrequency), 1);
+	default:
+	{
+		break;
+	}
 	}
 }
 
-class UDAReplicationGraphNode_AlwaysRelevant_ForConnection* UDAReplicationGraph::GetAlwaysRelevantNode(APlayerController* PlayerController)
+void UDAReplicationGraph::AddActorToGrid(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepPolicy MappingPolicy)
 {
-	if (PlayerController != NULL)
+	// The grid can not grow below its bias without a full rebuild, which is what bDisableSpatialRebuilding avoids.
+	// The packed grid grows a few rows per frame instead, so out of bounds actors are kept there
+	const FVector Location = ActorInfo.Actor->GetActorLocation();
+	const bool bOutOfBounds = (UsesGridOverflow() == true) && ((Location.X < GridNode->SpatialBias.X) || (Location.Y < GridNode->SpatialBias.Y));
+
+	if ((UsesGridOverflow() == true) && (MappingPolicy != EClassRepPolicy::Spatialize_Static))
 	{
-		if (UNetConnection* NetConnection = PlayerController->NetConnection)
-		{
-			if (UNetReplicationGraphConnection* GraphConnection = FindOrAddConnectionManager(NetConnection))
-			{
-				for (UReplicationGraphNode* ConnectionNode : GraphConnection->GetConnectionGraphNodes())
-				{
-					UDAReplicationGraphNode_AlwaysRelevant_ForConnection* Node = Cast<UDAReplicationGraphNode_AlwaysRelevant_ForConnection>(ConnectionNode);
-					if (Node != NULL)
-					{
-						return Node;
-					}
-				}
-			}
-		}
+		FDAGridMovableActor& MovableActor = GridMovableActors.Add(ActorInfo.Actor);
+		MovableActor.Policy = MappingPolicy;
+		ScheduleGridBoundsCheck(ActorInfo.Actor, MovableActor, Location, bOutOfBounds);
 	}
 
-	return nullptr;
-}
+	if (bOutOfBounds == true)
+	{
+		GridOutOfBoundsActors.Add(ActorInfo.Actor);
+		PackedGridNode->NotifyAddNetworkActor(ActorInfo);
+		return;
+	}
 
-#if WITH_GAMEPLAY_DEBUGGER
-void UDAReplicationGraph::OnGameplayDebuggerOwnerChange(AGameplayDebuggerCategoryReplicator* Debugger, APlayerController* OldOwner)
-{
-	if (UDAReplicationGraphNode_AlwaysRelevant_ForConnection* Node = GetAlwaysRelevantNode(OldOwner))
+	switch (MappingPolicy)
+	{
+	case EClassRepPolicy::Spatialize_Static:
 	{
-		Node->GameplayDebugger = nullptr;
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
 	}
 
-	if (UDAReplicationGraphNode_AlwaysRelevant_ForConnection* Node = GetAlwaysRelevantNode(Debugger->GetReplicationOwner()))
+	case EClassRepPolicy::Spatialize_Dormancy:
+	{
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	}
+
+	default:
 	{
-		Node->GameplayDebugger = Debugger;
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	}
 	}
 }
-#endif
 
-void UDAReplicationGraph::OnCharacterNewWeapon(class ADACharacter* Pawn, class ADAWeapon* NewWeapon, class ADAWeapon* OldWeapon)
+void UDAReplicationGraph::RemoveActorFromGrid(const FNewReplicatedActorInfo& ActorInfo, EClassRepPolicy MappingPolicy)
 {
-	if (!Pawn || Pawn->GetWorld() != GetWorld())
+	FDAGridMovableActor MovableActor;
+	if (GridMovableActors.RemoveAndCopyValue(ActorInfo.Actor, MovableActor) == true)
+	{
+		GridCheckBuckets[MovableActor.CheckBucket].RemoveSingleSwap(ActorInfo.Actor, false);
+	}
+
+	if (GridOutOfBoundsActors.Remove(ActorInfo.Actor) > 0)
 	{
+		PackedGridNode->NotifyRemoveNetworkActor(ActorInfo);
 		return;
 	}
 
-	FGlobalActorReplicationInfo& ActorInfo = GlobalActorReplicationInfoMap.Get(Pawn);
-	ActorInfo.DependentActorList.PrepareForWrite();
+	switch (MappingPolicy)
+	{
+	case EClassRepPolicy::Spatialize_Static:
+	{
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	}
 
-	if (NewWeapon != nullptr)
+	case EClassRepPolicy::Spatialize_Dormancy:
 	{
-		ActorInfo.DependentActorList.Add(NewWeapon);
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
 	}
 
-	if (OldWeapon != nullptr)
+	default:
 	{
-		ActorInfo.DependentActorList.Remove(OldWeapon);
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	}
 	}
 }
 
-EClassRepPolicy UDAReplicationGraph::GetMappingPolicy(const UClass* InClass)
+void UDAReplicationGraph::UpdateGridOutOfBoundsActors()
 {
-	return ClassRepPolicies.Get(InClass) != NULL ? *ClassRepPolicies.Get(InClass) : EClassRepPolicy::NotRouted;
+	if (UsesGridOverflow() == false)
+	{
+		return;
+	}
+
+	// Actors only move back into the grid half a cell inside the bias, so one standing on the edge does not flip every frame
+	const FVector2D Bias = GridNode->SpatialBias;
+	const float ReturnMargin = GridNode->CellSize * 0.5f;
+
+	// Rescheduled actors always go to another bucket, so this one is not modified while it is iterated
+	TArray<FActorRepListType>& Bucket = GridCheckBuckets[GetReplicationGraphFrame() % GridCheckBucketCount];
+	for (FActorRepListType Actor : Bucket)
+	{
+		FDAGridMovableActor& MovableActor = GridMovableActors.FindChecked(Actor);
+		const FVector Location = Actor->GetActorLocation();
+		const bool bOutOfBounds = GridOutOfBoundsActors.Contains(Actor);
+
+		bool bMove = false;
+		if (bOutOfBounds == false)
+		{
+			bMove = (Location.X < Bias.X) || (Location.Y < Bias.Y);
+		}
+		else
+		{
+			bMove = (Location.X >= Bias.X + ReturnMargin) && (Location.Y >= Bias.Y + ReturnMargin);
+		}
+
+		ScheduleGridBoundsCheck(Actor, MovableActor, Location, (bOutOfBounds != bMove));
+
+		if (bMove == false)
+		{
+			continue;
+		}
+
+		FNewReplicatedActorInfo ActorInfo(Actor);
+		FGlobalActorReplicationInfo& GlobalInfo = GlobalActorReplicationInfoMap.Get(Actor);
+
+		if (bOutOfBounds == false)
+		{
+			if (MovableActor.Policy == EClassRepPolicy::Spatialize_Dormancy)
+			{
+				GridNode->RemoveActor_Dormancy(ActorInfo);
+			}
+			else
+			{
+				GridNode->RemoveActor_Dynamic(ActorInfo);
+			}
+
+			GridOutOfBoundsActors.Add(Actor);
+			PackedGridNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		else
+		{
+			GridOutOfBoundsActors.Remove(Actor);
+			PackedGridNode->NotifyRemoveNetworkActor(ActorInfo);
+
+			if (MovableActor.Policy == EClassRepPolicy::Spatialize_Dormancy)
+			{
+				GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			}
+			else
+			{
+				GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			}
+		}
+	}
+
+	Bucket.Reset();
 }
 
-// --------------------------------------------------
-// UDAReplicationGraphNode_AlwaysRelevant_ForConnection
+void UDAReplicationGraph::ScheduleGridBoundsCheck(FActorRepListType Actor, FDAGridMovableActor& MovableActor, const FVector& Location, bool bOutOfBounds)
+{
+	const FVector2D Bias = GridNode->SpatialBias;
+	const float ReturnMargin = GridNode->CellSize * 0.5f;
 
-void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+	// Distance the actor has to travel before it can leave the grid bias, or get back inside it
+	float Distance = 0.f;
+	if (bOutOfBounds == false)
+	{
+		Distance = FMath::Min(Location.X - Bias.X, Location.Y - Bias.Y);
+	}
+	else
+	{
+		Distance = FMath::Max(Bias.X + ReturnMargin - Location.X, Bias.Y + ReturnMargin - Location.Y);
+	}
+
+	const float MaxMovePerFrame = FMath::Max(GridBoundsCheckMaxMovePerFrame, 1.f);
+	const int32 FramesUntilCheck = FMath::Clamp(FMath::FloorToInt(Distance / MaxMovePerFrame), 1, GridCheckBucketCount - 1);
+
+	MovableActor.CheckBucket = (GetReplicationGraphFrame() + FramesUntilCheck) % GridCheckBucketCount;
+	GridCheckBuckets[MovableActor.CheckBucket].Add(Actor);
+}
+
+void UDAReplicationGraph::ReloadClassPolicies(FOutputDevice& Ar)
 {
-	Super::GatherActorListsForConnection(Params);
+	// Re-reads the config files from disk, not just the config cache
+	FString EngineIni;
+	FConfigCacheIni::LoadGlobalIniFile(EngineIni, TEXT("Engine"), nullptr, true);
+	ReloadConfig();
 
-	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+	// The policy and class settings every actor has before the reload
+	struct FReloadedActor
+	{
+		FActorRepListType Actor;
+		EClassRepPolicy Policy;
+		FClassReplicationInfo Settings;
+		int32 DensityClassIdx;
+	};
 
-	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
-	TMap<FName, FActorRepListRefView>& AlwaysRelevantStreamingLevelActors = RepGraph->AlwaysRelevantStreamingLevelActors;
+	TArray<FReloadedActor> ReloadedActors;
+	for (auto It = GlobalActorReplicationInfoMap.CreateActorMapIterator(); It; ++It)
+	{
+		FActorRepListType Actor = It.Key();
+		if ((Actor != nullptr) && (Actor->IsPendingKill() == false))
+		{
+			const int32* DensityClassIdx = DensityCulledActors.Find(Actor);
+			ReloadedActors.Add({ Actor, GetMappingPolicy(Actor->GetClass()), GlobalActorReplicationInfoMap.Get(Actor).Settings, DensityClassIdx != nullptr ? *DensityClassIdx : INDEX_NONE });
+		}
+	}
 
-	for (int32 Idx = AlwaysRelevantStreamingLevels.Num() - 1; Idx >= 0; --Idx)
+	const bool bHadWeaponReplicationTier = bUseWeaponReplicationTier;
+
+	InitClassPolicies();
+	InitDensityCullClasses();
+
+	DensityCulledActors.Reset();
+
+	int32 NumRerouted = 0;
+	for (const FReloadedActor& Reloaded : ReloadedActors)
 	{
-		FName StreamingLevel = AlwaysRelevantStreamingLevels[Idx];
-		FActorRepListRefView* ListPtr = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
+		FActorRepListType Actor = Reloaded.Actor;
 
-		if (ListPtr == nullptr)
+		FGlobalActorReplicationInfo& GlobalInfo = GlobalActorReplicationInfoMap.Get(Actor);
+		GlobalInfo.Settings = GlobalActorReplicationInfoMap.GetClassInfo(Actor->GetClass());
+
+		const FDADensityCullClass* DensityClass = FindDensityCullClass(Actor->GetClass());
+		const int32 DensityClassIdx = DensityClass != nullptr ? (int32)(DensityClass - DensityCullClasses.GetData()) : INDEX_NONE;
+		if (DensityClass != nullptr)
 		{
-			AlwaysRelevantStreamingLevels.RemoveAtSwap(Idx, 1, false);
-			continue;
+			DensityCulledActors.Add(Actor, DensityClassIdx);
 		}
 
-		FActorRepListRefView& RepList = *ListPtr;
-		if (RepList.Num() > 0)
+		// Connection infos copy the class settings when they are created. Values the connection nodes changed for the
+		// connection are kept, the nodes set them again from the new class settings on their next gather. A density
+		// cull rule that changed has nothing to set them again, so those go back to the class cull distance
+		const bool bDensityRuleChanged = (Reloaded.DensityClassIdx != DensityClassIdx);
+		for (UNetReplicationGraphConnection* Connection : Connections)
 		{
-			bool bAllDormant = true;
-			for (FActorRepListType Actor : RepList)
+			if (FConnectionReplicationActorInfo* ConnectionInfo = Connection->ActorInfoMap.Find(Actor))
 			{
-				FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
-				if (ConnectionActorInfo.bDormantOnConnection == false)
+				if ((bDensityRuleChanged == true) || (ConnectionInfo->CullDistanceSquared == Reloaded.Settings.CullDistanceSquared))
 				{
-					bAllDormant = false;
-					break;
+					ConnectionInfo->CullDistanceSquared = GlobalInfo.Settings.CullDistanceSquared;
+				}
+
+				if (ConnectionInfo->ReplicationPeriodFrame == Reloaded.Settings.ReplicationPeriodFrame)
+				{
+					ConnectionInfo->ReplicationPeriodFrame = GlobalInfo.Settings.ReplicationPeriodFrame;
 				}
 			}
+		}
 
-			if (bAllDormant == true)
+		const EClassRepPolicy NewPolicy = GetMappingPolicy(Actor->GetClass());
+		if (NewPolicy != Reloaded.Policy)
+		{
+			FNewReplicatedActorInfo ActorInfo(Actor);
+			RemoveActorFromPolicyNodes(ActorInfo, Reloaded.Policy);
+			AddActorToPolicyNodes(ActorInfo, GlobalInfo, NewPolicy);
+
+			++NumRerouted;
+		}
+
+		// Without the weapon tier the weapon is a dependent actor of its pawn, OnCharacterNewWeapon only runs on weapon changes
+		ADACharacter* Character = Cast<ADACharacter>(Actor);
+		if ((bUseWeaponReplicationTier != bHadWeaponReplicationTier) && (Character != nullptr) && (Character->Weapon != nullptr))
+		{
+			GlobalInfo.DependentActorList.PrepareForWrite();
+
+			if (bUseWeaponReplicationTier == false)
 			{
-				AlwaysRelevantStreamingLevels.RemoveAtSwap(Idx, 1, false);
+				GlobalInfo.DependentActorList.ConditionalAdd(Character->Weapon);
 			}
 			else
 			{
-				Params.OutGatheredReplicationLists.AddReplicationActorList(RepList);
+				GlobalInfo.DependentActorList.Remove(Character->Weapon);
 			}
 		}
 	}
 
-#if WITH_GAMEPLAY_DEBUGGER
-	if (GameplayDebugger != NULL)
+	if (PackedGridNode != nullptr)
 	{
-		ReplicationActorList.ConditionalAdd(GameplayDebugger);
+		PackedGridNode->MaxNewCellsPerFrame = PackedGridMaxNewCellsPerFrame;
+		PackedGridNode->UnviewedCellUpdatePeriod = PackedGridUnviewedCellUpdatePeriod;
 	}
-#endif
-}
 
-void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityAdd(FName LevelName, UWorld* LevelWorld)
-{
-	AlwaysRelevantStreamingLevels.Add(LevelName);
-}
+	if (CharacterGridNode != nullptr)
+	{
+		CharacterGridNode->MaxNewCellsPerFrame = PackedGridMaxNewCellsPerFrame;
+		CharacterGridNode->UnviewedCellUpdatePeriod = CharacterGridUnviewedCellUpdatePeriod;
+	}
 
-void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove(FName LevelName)
+	Ar.Logf(TEXT("Reloaded %d class policy rules and %d density cull rules, %d actors updated, %d moved to other nodes"), ClassPolicyRules.Num(), DensityCullClasses.Num(), ReloadedActors.Num(), NumRerouted);
+
+	if ((GridNode->CellSize != GridCellSize) || (GridNode->SpatialBias != FVector2D(SpatialBiasX, SpatialBiasY)))
+	{
+		Ar.Logf(TEXT("Grid cell size and spatial bias changes apply on the next server start"));
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice ReloadRepPoliciesCommand(
+	TEXT("DA.ReloadRepPolicies"),
+	TEXT("Re-reads the replication graph class policy rules, cull distances and replication periods from the engine config and applies them to the running server"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		UDAReplicationGraph* RepGraph = NetDriver != nullptr ? Cast<UDAReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (RepGraph == nullptr)
+		{
+			Ar.Logf(TEXT("No DAReplicationGraph running in this world"));
+			return;
+		}
+
+		RepGraph->ReloadClassPolicies(Ar);
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice RepGraphTraceCommand(
+	TEXT("DA.RepGraphTrace"),
+	TEXT("DA.RepGraphTrace start [actors] [positions] | stop. Writes what the replication graph gathered, culled and sent per connection to Saved/RepGraph, summarize it with the DARepGraphTrace commandlet. With positions the trace can be replayed by its -gridsim mode"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		UDAReplicationGraph* RepGraph = NetDriver != nullptr ? Cast<UDAReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (RepGraph == nullptr)
+		{
+			Ar.Logf(TEXT("No DAReplicationGraph running in this world"));
+			return;
+		}
+
+		FDARepGraphTracer& Tracer = RepGraph->GetTracer();
+
+		if ((Args.Num() > 0) && (Args[0] == TEXT("start")))
+		{
+			const bool bActorDetail = Args.Contains(TEXT("actors"));
+			const bool bPositions = Args.Contains(TEXT("positions"));
+			const FString Filename = FPaths::ProjectSavedDir() / TEXT("RepGraph") / FString::Printf(TEXT("Trace-%s.dart"), *FDateTime::Now().ToString());
+
+			if (Tracer.Start(Filename, bActorDetail, bPositions) == true)
+			{
+				Ar.Logf(TEXT("Tracing to %s"), *Filename);
+			}
+			else
+			{
+				Ar.Logf(TEXT("Could not open %s"), *Filename);
+			}
+		}
+		else if ((Args.Num() > 0) && (Args[0] == TEXT("stop")))
+		{
+			Tracer.Stop();
+			Ar.Logf(TEXT("Trace stopped"));
+		}
+		else
+		{
+			Ar.Logf(TEXT("Usage: DA.RepGraphTrace start [actors] [positions] | stop. Tracing is %s"), Tracer.IsRunning() ? TEXT("running") : TEXT("stopped"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice RepGraphGoldenCommand(
+	TEXT("DA.RepGraphGolden"),
+	TEXT("DA.RepGraphGolden record <name> [frames] | compare <name> [frames] [budget]. Records the actors every connection gathers to Test/RepGraph, or compares a rerun of the same scenario against it and logs an error for every difference. With budget only gathering more actors fails"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		UDAReplicationGraph* RepGraph = NetDriver != nullptr ? Cast<UDAReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (RepGraph == nullptr)
+		{
+			Ar.Logf(TEXT("No DAReplicationGraph running in this world"));
+			return;
+		}
+
+		FDARepGraphGolden& Golden = RepGraph->GetGolden();
+		const int32 NumFrames = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 0;
+
+		if ((Args.Num() > 1) && (Args[0] == TEXT("record")))
+		{
+			Golden.StartRecord(Args[1], NumFrames > 0 ? NumFrames : 300);
+			Ar.Logf(TEXT("Recording golden file %s"), *FDARepGraphGolden::GetFilename(Args[1]));
+		}
+		else if ((Args.Num() > 1) && (Args[0] == TEXT("compare")))
+		{
+			if (Golden.StartCompare(Args[1], NumFrames, Args.Contains(TEXT("budget")), RepGraph->GetGoldenTimeTolerance(), Ar) == true)
+			{
+				Ar.Logf(TEXT("Comparing against golden file %s"), *FDARepGraphGolden::GetFilename(Args[1]));
+			}
+		}
+		else
+		{
+			Ar.Logf(TEXT("Usage: DA.RepGraphGolden record <name> [frames] | compare <name> [frames] [budget]"));
+		}
+	}));
+
+int32 UDAReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+	const double ReplicateSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+#if STATS
+	// Lets the actor based and component based weapon setups be compared by channel count
+	int32 NumActorChannels = 0;
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		NumActorChannels += Connection->NetConnection->ActorChannels.Num();
+	}
+
+	SET_DWORD_STAT(STAT_DARepGraph_ActorChannels, NumActorChannels);
+	SET_DWORD_STAT(STAT_DARepGraph_NetworkActors, GlobalActorReplicationInfoMap.Num());
+
+	// The memory stats walk every actor info, only refresh them every few seconds while stats are collected
+	if ((FThreadStats::IsCollectingData() == true) && (GetReplicationGraphFrame() % 300 == 0))
+	{
+		FOutputDeviceNull NullOutput;
+		ReportMemory(NullOutput, false, false);
+	}
+#endif
+
+	FlushRepListFrame();
+
+	if (Tracer.IsRunning() == true)
+	{
+		Tracer.RecordPositions(GetReplicationGraphFrame(), Connections, GlobalActorReplicationInfoMap, [this](const UClass* Class) { return GetMappingPolicy(Class); });
+		Tracer.FinishFrame(GetReplicationGraphFrame());
+	}
+
+	if (Golden.IsRunning() == true)
+	{
+		Golden.FinishFrame(ReplicateSeconds);
+	}
+
+	return Result;
+}
+
+void UDAReplicationGraph::SetRepDriverWorld(UWorld* InWorld)
+{
+	Super::SetRepDriverWorld(InWorld);
+
+	// Seamless travel keeps this graph, top the rep list pool up for the new map once the graph is initialized
+	if ((InWorld != nullptr) && (RepListBuckets.Num() > 0))
+	{
+		PreAllocateRepListsFromProfile(InWorld);
+	}
+}
+
+void UDAReplicationGraph::BeginDestroy()
+{
+	SaveRepListProfile();
+	Tracer.Stop();
+
+	ADACharacter::OnNewWeapon.RemoveAll(this);
+	ADACharacter::OnTeamChanged.RemoveAll(this);
+
+#if WITH_GAMEPLAY_DEBUGGER
+	AGameplayDebuggerCategoryReplicator::NotifyDebuggerOwnerChange.RemoveAll(this);
+#endif
+
+	Super::BeginDestroy();
+}
+
+FString UDAReplicationGraph::GetRepListProfileFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("RepGraph") / TEXT("RepListProfile.ini");
+}
+
+void UDAReplicationGraph::PreAllocateRepListsFromProfile(UWorld* World)
+{
+	// The pool sizes used when a map has no profile yet
+	static const TPair<int32, int32> DefaultBuckets[] = { { 3, 12 }, { 6, 12 }, { 128, 64 }, { 512, 16 } };
+
+	RepListProfileMap = World != nullptr ? UWorld::RemovePIEPrefix(World->GetMapName()) : FString();
+
+	FConfigFile Profile;
+	if ((bUseRepListProfile == true) && (RepListProfileMap.IsEmpty() == false))
+	{
+		Profile.Read(GetRepListProfileFilename());
+	}
+
+	if (RepListBuckets.Num() == 0)
+	{
+		for (const TPair<int32, int32>& DefaultBucket : DefaultBuckets)
+		{
+			RepListBuckets.AddDefaulted_GetRef().ListSize = DefaultBucket.Key;
+		}
+	}
+
+	SIZE_T PreallocatedBytes = 0;
+
+	LiveRepLists.Reset();
+
+	for (int32 Idx = 0; Idx < RepListBuckets.Num(); ++Idx)
+	{
+		FDARepListBucket& Bucket = RepListBuckets[Idx];
+
+		int32 NumLists = DefaultBuckets[Idx].Value;
+
+		int32 SavedPeak = 0;
+		if (Profile.GetInt(*RepListProfileMap, *FString::Printf(TEXT("PeakLists_%d"), Bucket.ListSize), SavedPeak) == true)
+		{
+			NumLists = FMath::Max(FMath::CeilToInt(SavedPeak * RepListProfileHeadroom), 1);
+		}
+
+		// The pool never shrinks and is kept across seamless travel, so only the lists missing for this map are added
+		if (NumLists > Bucket.PreallocatedLists)
+		{
+			PreAllocateRepList(Bucket.ListSize, NumLists - Bucket.PreallocatedLists);
+			Bucket.PreallocatedLists = NumLists;
+		}
+
+		Bucket.PeakLists = 0;
+		Bucket.LiveLists = 0;
+		PreallocatedBytes += (SIZE_T)Bucket.ListSize * Bucket.PreallocatedLists * sizeof(FActorRepListType);
+	}
+
+	RepListPreallocatedBytes = PreallocatedBytes;
+	SET_MEMORY_STAT(STAT_DARepList_PreallocatedMemory, PreallocatedBytes);
+}
+
+void UDAReplicationGraph::SaveRepListProfile()
+{
+	if ((bUseRepListProfile == false) || (RepListProfileMap.IsEmpty() == true))
+	{
+		return;
+	}
+
+	const FString Filename = GetRepListProfileFilename();
+
+	FConfigFile Profile;
+	Profile.Read(Filename);
+
+	for (const FDARepListBucket& Bucket : RepListBuckets)
+	{
+		const FString Key = FString::Printf(TEXT("PeakLists_%d"), Bucket.ListSize);
+
+		int32 SavedPeak = 0;
+		Profile.GetInt(*RepListProfileMap, *Key, SavedPeak);
+
+		Profile.SetInt(*RepListProfileMap, *Key, FMath::Max(Bucket.PeakLists, FMath::FloorToInt(SavedPeak * RepListProfileDecay)));
+	}
+
+	Profile.Dirty = true;
+	Profile.Write(Filename);
+
+	// Only saved once per session
+	RepListProfileMap.Empty();
+}
+
+namespace
+{
+	/** Memory of one category of the report */
+	struct FDAMemoryCounter
+	{
+		int32 Count = 0;
+		SIZE_T Bytes = 0;
+
+		void Add(SIZE_T InBytes)
+		{
+			++Count;
+			Bytes += InBytes;
+		}
+	};
+
+	/** Collects the report lines to write them to a file */
+	struct FDAReportOutputDevice : public FOutputDevice
+	{
+		FString Text;
+
+		virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override
+		{
+			Text += V;
+			Text += LINE_TERMINATOR;
+		}
+	};
+
+	/** Rough cost of one TMap element on top of its key and value, the hash bucket and the sparse array bookkeeping */
+	const SIZE_T MapElementOverhead = sizeof(int32) * 3;
+
+	void LogClassCounters(FOutputDevice& Ar, const TCHAR* Title, TMap<const UClass*, FDAMemoryCounter>& Counters)
+	{
+		Counters.ValueSort([](const FDAMemoryCounter& A, const FDAMemoryCounter& B) { return A.Bytes > B.Bytes; });
+
+		Ar.Logf(TEXT("  %s per class:"), Title);
+		for (const TPair<const UClass*, FDAMemoryCounter>& Pair : Counters)
+		{
+			Ar.Logf(TEXT("    %-48s %6d actors %10llu bytes"), *GetNameSafe(Pair.Key), Pair.Value.Count, (uint64)Pair.Value.Bytes);
+		}
+	}
+}
+
+void UDAReplicationGraph::ReportMemory(FOutputDevice& Ar, bool bPerClass, bool bPerConnection)
+{
+	SIZE_T TotalBytes = 0;
+
+	// ---------------------------------
+	// Global actor infos
+
+	FDAMemoryCounter GlobalInfos;
+	TMap<const UClass*, FDAMemoryCounter> GlobalInfosPerClass;
+
+	for (auto It = GlobalActorReplicationInfoMap.CreateActorMapIterator(); It; ++It)
+	{
+		FActorRepListType Actor = It.Key();
+		const FGlobalActorReplicationInfo& GlobalInfo = GlobalActorReplicationInfoMap.Get(Actor);
+
+		const SIZE_T Bytes = sizeof(FActorRepListType) + sizeof(FGlobalActorReplicationInfo) + MapElementOverhead + GlobalInfo.DependentActorList.Num() * sizeof(FActorRepListType);
+		GlobalInfos.Add(Bytes);
+
+		if (bPerClass == true)
+		{
+			GlobalInfosPerClass.FindOrAdd(Actor->GetClass()).Add(Bytes);
+		}
+	}
+
+	Ar.Logf(TEXT("GlobalActorReplicationInfoMap: %d actors, %llu bytes"), GlobalInfos.Count, (uint64)GlobalInfos.Bytes);
+	if (bPerClass == true)
+	{
+		LogClassCounters(Ar, TEXT("GlobalActorReplicationInfoMap"), GlobalInfosPerClass);
+	}
+
+	SET_MEMORY_STAT(STAT_DARepGraphMemory_GlobalActorInfos, GlobalInfos.Bytes);
+	TotalBytes += GlobalInfos.Bytes;
+
+	// ---------------------------------
+	// Connection actor infos
+
+	FDAMemoryCounter ConnectionInfos;
+	TMap<const UClass*, FDAMemoryCounter> ConnectionInfosPerClass;
+
+	const SIZE_T ConnectionInfoBytes = sizeof(FActorRepListType) + sizeof(FConnectionReplicationActorInfo) + MapElementOverhead;
+
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		FDAMemoryCounter ThisConnection;
+
+		for (auto It = Connection->ActorInfoMap.CreateIterator(); It; ++It)
+		{
+			ThisConnection.Add(ConnectionInfoBytes);
+
+			if (bPerClass == true)
+			{
+				ConnectionInfosPerClass.FindOrAdd(It.Key()->GetClass()).Add(ConnectionInfoBytes);
+			}
+		}
+
+		if (bPerConnection == true)
+		{
+			Ar.Logf(TEXT("  Connection %s: %d actor infos, %llu bytes, %d nodes"), *Connection->NetConnection->LowLevelDescribe(), ThisConnection.Count, (uint64)ThisConnection.Bytes, Connection->GetConnectionGraphNodes().Num());
+		}
+
+		ConnectionInfos.Count += ThisConnection.Count;
+		ConnectionInfos.Bytes += ThisConnection.Bytes;
+	}
+
+	Ar.Logf(TEXT("Connection ActorInfoMaps: %d connections, %d actor infos, %llu bytes"), Connections.Num(), ConnectionInfos.Count, (uint64)ConnectionInfos.Bytes);
+	if (bPerClass == true)
+	{
+		LogClassCounters(Ar, TEXT("Connection ActorInfoMaps"), ConnectionInfosPerClass);
+	}
+
+	SET_MEMORY_STAT(STAT_DARepGraphMemory_ConnectionActorInfos, ConnectionInfos.Bytes);
+	TotalBytes += ConnectionInfos.Bytes;
+
+	// ---------------------------------
+	// Nodes, grid cells are child nodes of the grid node so they are found with the other nodes
+
+	TMap<const UClass*, FDAMemoryCounter> NodesPerClass;
+	FDAMemoryCounter Nodes;
+	TArray<FActorRepListType> NodeActors;
+
+	// A node's debugging actors include the actors of all its child nodes, so they are only collected from the top
+	// level nodes. Child nodes are still counted for their own size
+	TSet<UReplicationGraphNode*> TopLevelNodes;
+	TopLevelNodes.Append(GlobalGraphNodes);
+	for (auto& ConnectionList : { Connections, PendingConnections })
+	{
+		for (UNetReplicationGraphConnection* Connection : ConnectionList)
+		{
+			TopLevelNodes.Append(Connection->GetConnectionGraphNodes());
+		}
+	}
+
+	ForEachObjectWithOuter(this, [&](UObject* Object)
+	{
+		UReplicationGraphNode* Node = Cast<UReplicationGraphNode>(Object);
+		if (Node == nullptr)
+		{
+			return;
+		}
+
+		NodeActors.Reset();
+		if (TopLevelNodes.Contains(Node) == true)
+		{
+			Node->GetAllActorsInNode_Debugging(NodeActors);
+		}
+
+		SIZE_T Bytes = Node->GetClass()->GetStructureSize() + NodeActors.Num() * sizeof(FActorRepListType);
+		if (UDAReplicationGraphNode_PackedGrid* PackedGrid = Cast<UDAReplicationGraphNode_PackedGrid>(Node))
+		{
+			Bytes += PackedGrid->GetAllocatedSize();
+		}
+
+		Nodes.Add(Bytes);
+		NodesPerClass.FindOrAdd(Node->GetClass()).Add(Bytes);
+	});
+
+	Ar.Logf(TEXT("Nodes: %d nodes, %llu bytes"), Nodes.Count, (uint64)Nodes.Bytes);
+	NodesPerClass.ValueSort([](const FDAMemoryCounter& A, const FDAMemoryCounter& B) { return A.Bytes > B.Bytes; });
+	for (const TPair<const UClass*, FDAMemoryCounter>& Pair : NodesPerClass)
+	{
+		Ar.Logf(TEXT("    %-48s %6d nodes %10llu bytes"), *GetNameSafe(Pair.Key), Pair.Value.Count, (uint64)Pair.Value.Bytes);
+	}
+
+	if (PackedGridNode != nullptr)
+	{
+		Ar.Logf(TEXT("  Packed grid: %d cells, %llu bytes"), PackedGridNode->GetNumCells(), (uint64)PackedGridNode->GetAllocatedSize());
+	}
+
+	if (CharacterGridNode != nullptr)
+	{
+		Ar.Logf(TEXT("  Character grid: %d cells, %llu bytes"), CharacterGridNode->GetNumCells(), (uint64)CharacterGridNode->GetAllocatedSize());
+	}
+
+	SET_MEMORY_STAT(STAT_DARepGraphMemory_Nodes, Nodes.Bytes);
+	TotalBytes += Nodes.Bytes;
+
+	// ---------------------------------
+	// Streaming level lists
+
+	FDAMemoryCounter StreamingLevelLists;
+	for (const TPair<FName, FActorRepListRefView>& Pair : AlwaysRelevantStreamingLevelActors)
+	{
+		StreamingLevelLists.Add(sizeof(FName) + sizeof(FActorRepListRefView) + MapElementOverhead + Pair.Value.Num() * sizeof(FActorRepListType));
+	}
+
+	Ar.Logf(TEXT("AlwaysRelevantStreamingLevelActors: %d levels, %llu bytes"), StreamingLevelLists.Count, (uint64)StreamingLevelLists.Bytes);
+
+	SET_MEMORY_STAT(STAT_DARepGraphMemory_StreamingLevelLists, StreamingLevelLists.Bytes);
+	TotalBytes += StreamingLevelLists.Bytes;
+
+	// ---------------------------------
+	// Rep list pool
+
+	Ar.Logf(TEXT("Rep list pool: %llu bytes pre-allocated"), (uint64)RepListPreallocatedBytes);
+	for (const FDARepListBucket& Bucket : RepListBuckets)
+	{
+		Ar.Logf(TEXT("    Size %4d: %4d pre-allocated, %4d live, peak %4d"), Bucket.ListSize, Bucket.PreallocatedLists, Bucket.LiveLists, Bucket.PeakLists);
+	}
+
+	TotalBytes += RepListPreallocatedBytes;
+
+	Ar.Logf(TEXT("Total: %llu bytes"), (uint64)TotalBytes);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice RepGraphMemoryCommand(
+	TEXT("DA.RepGraphMemory"),
+	TEXT("Reports the memory used by the replication graph. Args: [class] [connection] [file] to break it down per class, per connection and to dump it to Saved/RepGraph"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		UDAReplicationGraph* RepGraph = NetDriver != nullptr ? Cast<UDAReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (RepGraph == nullptr)
+		{
+			Ar.Logf(TEXT("No DAReplicationGraph running in this world"));
+			return;
+		}
+
+		const bool bPerClass = Args.Contains(TEXT("class"));
+		const bool bPerConnection = Args.Contains(TEXT("connection"));
+
+		if (Args.Contains(TEXT("file")) == false)
+		{
+			RepGraph->ReportMemory(Ar, bPerClass, bPerConnection);
+			return;
+		}
+
+		FDAReportOutputDevice Report;
+		RepGraph->ReportMemory(Report, bPerClass, bPerConnection);
+
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("RepGraph") / FString::Printf(TEXT("Memory-%s.txt"), *FDateTime::Now().ToString());
+		FFileHelper::SaveStringToFile(Report.Text, *Filename);
+
+		Ar.Logf(TEXT("Replication graph memory report written to %s"), *Filename);
+	}));
+
+void UDAReplicationGraph::RecordGatheredList(const FActorRepListConstView& List)
+{
+	const int32 Num = List.Num();
+	if (Num == 0)
+	{
+		return;
+	}
+
+	// The pool hands out the smallest list that fits, lists bigger than the biggest size are not pre-allocated
+	int32 BucketIdx = 0;
+	while ((BucketIdx < RepListBuckets.Num()) && (Num > RepListBuckets[BucketIdx].ListSize))
+	{
+		++BucketIdx;
+	}
+
+	const FActorRepListType* ListData = &(*List.begin());
+	const uint32 FrameNum = GetReplicationGraphFrame();
+
+	FDALiveRepList* LiveList = LiveRepLists.Find(ListData);
+	if (LiveList != nullptr)
+	{
+		LiveList->LastGatherFrame = FrameNum;
+
+		// The list filled up past the bucket it was first seen in, it has been that size all along
+		if (BucketIdx > LiveList->BucketIdx)
+		{
+			if (LiveList->BucketIdx < RepListBuckets.Num())
+			{
+				--RepListBuckets[LiveList->BucketIdx].LiveLists;
+			}
+
+			if (BucketIdx < RepListBuckets.Num())
+			{
+				++RepListBuckets[BucketIdx].LiveLists;
+			}
+
+			LiveList->BucketIdx = BucketIdx;
+		}
+
+		return;
+	}
+
+	// A new list is a hit while its size has pre-allocated lists left
+	if ((BucketIdx < RepListBuckets.Num()) && (RepListBuckets[BucketIdx].LiveLists < RepListBuckets[BucketIdx].PreallocatedLists))
+	{
+		INC_DWORD_STAT(STAT_DARepList_PoolHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_DARepList_PoolMisses);
+	}
+
+	if (BucketIdx < RepListBuckets.Num())
+	{
+		++RepListBuckets[BucketIdx].LiveLists;
+	}
+
+	FDALiveRepList& NewList = LiveRepLists.Add(ListData);
+	NewList.BucketIdx = BucketIdx;
+	NewList.LastGatherFrame = FrameNum;
+}
+
+void UDAReplicationGraph::FlushRepListFrame()
+{
+	if (bUseRepListProfile == false)
+	{
+		return;
+	}
+
+	const uint32 FrameNum = GetReplicationGraphFrame();
+
+	for (auto It = LiveRepLists.CreateIterator(); It; ++It)
+	{
+		if (FrameNum - It.Value().LastGatherFrame > RepListLiveFrames)
+		{
+			if (It.Value().BucketIdx < RepListBuckets.Num())
+			{
+				--RepListBuckets[It.Value().BucketIdx].LiveLists;
+			}
+
+			It.RemoveCurrent();
+		}
+	}
+
+	for (FDARepListBucket& Bucket : RepListBuckets)
+	{
+		Bucket.PeakLists = FMath::Max(Bucket.PeakLists, Bucket.LiveLists);
+	}
+}
+
+void UDAReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* InClass, bool bSpatilize, float ServerMaxTickRate)
+{
+	if (AActor* CDO = Cast<AActor>(InClass->GetDefaultObject()))
+	{
+		InitClassReplicationInfo(Info, CDO->NetCullDistanceSquared, CDO->NetUpdateFrequency, bSpatilize, ServerMaxTickRate);
+	}
+}
+
+void UDAReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, float NetCullDistanceSquared, float NetUpdateFrequency, bool bSpatilize, float ServerMaxTickRate)
+{
+	if (bSpatilize == true)
+	{
+		Info.CullDistanceSquared = NetCullDistanceSquared;
+	}
+
+	Info.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ServerMaxTickRate / NetUpdateFrequency), 1);
+}
+
+class UDAReplicationGraphNode_AlwaysRelevant_ForConnection* UDAReplicationGraph::GetAlwaysRelevantNode(APlayerController* PlayerController)
+{
+	if (PlayerController != NULL)
+	{
+		if (UNetConnection* NetConnection = PlayerController->NetConnection)
+		{
+			if (UNetReplicationGraphConnection* GraphConnection = FindOrAddConnectionManager(NetConnection))
+			{
+				for (UReplicationGraphNode* ConnectionNode : GraphConnection->GetConnectionGraphNodes())
+				{
+					UDAReplicationGraphNode_AlwaysRelevant_ForConnection* Node = Cast<UDAReplicationGraphNode_AlwaysRelevant_ForConnection>(ConnectionNode);
+					if (Node != NULL)
+					{
+						return Node;
+					}
+				}
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+#if WITH_GAMEPLAY_DEBUGGER
+void UDAReplicationGraph::OnGameplayDebuggerOwnerChange(AGameplayDebuggerCategoryReplicator* Debugger, APlayerController* OldOwner)
+{
+	if (!Debugger || Debugger->GetWorld() != GetWorld())
+	{
+		return;
+	}
+
+	UDAReplicationGraphNode_AlwaysRelevant_ForConnection* OldNode = GetAlwaysRelevantNode(OldOwner);
+	if ((OldNode != nullptr) && (OldNode->GetGameplayDebugger() == Debugger))
+	{
+		OldNode->SetGameplayDebugger(nullptr);
+	}
+
+	if (UDAReplicationGraphNode_AlwaysRelevant_ForConnection* Node = GetAlwaysRelevantNode(Debugger->GetReplicationOwner()))
+	{
+		Node->SetGameplayDebugger(Debugger);
+	}
+}
+#endif
+
+void UDAReplicationGraph::OnCharacterNewWeapon(class ADACharacter* Pawn, class ADAWeapon* NewWeapon, class ADAWeapon* OldWeapon)
+{
+	if (!Pawn || Pawn->GetWorld() != GetWorld())
+	{
+		return;
+	}
+
+	// Weapons are routed on their own, the connection viewing the pawn picks up its weapon in its always relevant node
+	if (bUseWeaponReplicationTier == true)
+	{
+		return;
+	}
+
+	FGlobalActorReplicationInfo& ActorInfo = GlobalActorReplicationInfoMap.Get(Pawn);
+	ActorInfo.DependentActorList.PrepareForWrite();
+
+	if (NewWeapon != nullptr)
+	{
+		ActorInfo.DependentActorList.Add(NewWeapon);
+	}
+
+	if (OldWeapon != nullptr)
+	{
+		ActorInfo.DependentActorList.Remove(OldWeapon);
+	}
+}
+
+void UDAReplicationGraph::OnCharacterTeamChanged(ADACharacter* Pawn, uint8 OldTeam, uint8 NewTeam)
+{
+	if (!Pawn || Pawn->GetWorld() != GetWorld())
+	{
+		return;
+	}
+
+	RemoveTeamMember(Pawn, OldTeam);
+	AddTeamMember(Pawn, NewTeam);
+
+	// The old teammates' connections must cull the pawn again
+	const FClassReplicationInfo& Settings = GlobalActorReplicationInfoMap.Get(Pawn).Settings;
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		if (FConnectionReplicationActorInfo* ConnectionInfo = Connection->ActorInfoMap.Find(Pawn))
+		{
+			ConnectionInfo->CullDistanceSquared = Settings.CullDistanceSquared;
+			ConnectionInfo->ReplicationPeriodFrame = Settings.ReplicationPeriodFrame;
+		}
+	}
+}
+
+bool UDAReplicationGraph::IsSpectatorConnection(const FConnectionGatherActorListParameters& Params) const
+{
+	if (bUseSpectatorProfile == false)
+	{
+		return false;
+	}
+
+	const UNetConnection* NetConnection = Params.ConnectionManager.NetConnection;
+	if ((NetConnection != nullptr) && (NetConnection->IsA<UDemoNetConnection>() == true))
+	{
+		return true;
+	}
+
+	const APlayerController* PlayerController = Cast<APlayerController>(Params.Viewer.InViewer);
+	return (PlayerController != nullptr) && (PlayerController->PlayerState != nullptr) && (PlayerController->PlayerState->bOnlySpectator == true);
+}
+
+const FDASpectatorView& UDAReplicationGraph::GetSpectatorView(const FVector& ViewLocation, uint32 FrameNum, FIntPoint& OutCell)
+{
+	const float CellSize = FMath::Max(SpectatorViewCellSize, 1.f);
+	OutCell = FIntPoint(FMath::FloorToInt(ViewLocation.X / CellSize), FMath::FloorToInt(ViewLocation.Y / CellSize));
+
+	const uint32 GatherPeriod = (uint32)FMath::Max(SpectatorGatherPeriod, 1);
+
+	FDASpectatorView& View = SpectatorViews.FindOrAdd(OutCell);
+	View.LastUsedFrame = FrameNum;
+
+	if ((View.BuildFrame != 0) && (FrameNum - View.BuildFrame < GatherPeriod))
+	{
+		if (View.NumRemovalsApplied < SpectatorRemovedActors.Num())
+		{
+			View.Actors.PrepareForWrite();
+			for (int32 Idx = View.NumRemovalsApplied; Idx < SpectatorRemovedActors.Num(); ++Idx)
+			{
+				View.Actors.Remove(SpectatorRemovedActors[Idx]);
+			}
+
+			View.NumRemovalsApplied = SpectatorRemovedActors.Num();
+		}
+
+		return View;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DASpectator_Build);
+
+	// Views no spectator has used for a while go away, once every remaining view is up to date the removed actors are forgotten
+	bool bRemovalsApplied = true;
+	for (auto It = SpectatorViews.CreateIterator(); It; ++It)
+	{
+		if ((It.Key() != OutCell) && (FrameNum - It.Value().LastUsedFrame > GatherPeriod * 4))
+		{
+			It.RemoveCurrent();
+		}
+		else if ((It.Key() != OutCell) && (It.Value().NumRemovalsApplied < SpectatorRemovedActors.Num()))
+		{
+			bRemovalsApplied = false;
+		}
+	}
+
+	if (bRemovalsApplied == true)
+	{
+		SpectatorRemovedActors.Reset();
+		for (TPair<FIntPoint, FDASpectatorView>& SpectatorView : SpectatorViews)
+		{
+			SpectatorView.Value.NumRemovalsApplied = 0;
+		}
+	}
+
+	FDASpectatorView& BuiltView = SpectatorViews.FindChecked(OutCell);
+	BuiltView.BuildFrame = FMath::Max(FrameNum, 1u);
+	BuiltView.NumRemovalsApplied = SpectatorRemovedActors.Num();
+	BuiltView.Actors.PrepareForWrite();
+	BuiltView.Actors.Reset();
+
+	const FVector2D CellCenter = (FVector2D(OutCell) + FVector2D(0.5f, 0.5f)) * CellSize;
+
+	// Only the spatial nodes are searched, not-spatialized actors reach spectators through the always relevant nodes like for players
+	GridNode->GatherWithinRadius(CellCenter, SpectatorViewRadius, BuiltView.Actors);
+
+	if (PackedGridNode != nullptr)
+	{
+		PackedGridNode->GatherWithinRadius(CellCenter, SpectatorViewRadius, BuiltView.Actors);
+	}
+
+	if (CharacterGridNode != nullptr)
+	{
+		CharacterGridNode->GatherWithinRadius(CellCenter, SpectatorViewRadius, BuiltView.Actors);
+	}
+
+	SET_DWORD_STAT(STAT_DASpectator_Views, SpectatorViews.Num());
+	return BuiltView;
+}
+
+void UDAReplicationGraph::AddTeamMember(FActorRepListType Actor, uint8 Team)
+{
+	if ((bUseTeamRelevancy == false) || (Team == ADACharacter::NoTeam))
+	{
+		return;
+	}
+
+	FActorRepListRefView& TeamList = TeamMembers.FindOrAdd(Team);
+	TeamList.PrepareForWrite();
+	TeamList.ConditionalAdd(Actor);
+}
+
+void UDAReplicationGraph::RemoveTeamMember(FActorRepListType Actor, uint8 Team)
+{
+	if (FActorRepListRefView* TeamList = TeamMembers.Find(Team))
+	{
+		TeamList->PrepareForWrite();
+		TeamList->Remove(Actor);
+	}
+}
+
+FDADensityCullClass* UDAReplicationGraph::FindDensityCullClass(const UClass* InClass)
+{
+	return DensityCullClasses.FindByPredicate([&](const FDADensityCullClass& DensityClass) { return InClass->IsChildOf(DensityClass.Class); });
+}
+
+EClassRepPolicy UDAReplicationGraph::GetMappingPolicy(const UClass* InClass)
+{
+	const EClassRepPolicy* Policy = ClassRepPolicies.Get(InClass);
+	return Policy != NULL ? *Policy : EClassRepPolicy::NotRouted;
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_AlwaysRelevant_ForConnection
+
+void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	const int32 NumListsBefore = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+
+	Super::GatherActorListsForConnection(Params);
+
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+	TMap<FName, FActorRepListRefView>& AlwaysRelevantStreamingLevelActors = RepGraph->AlwaysRelevantStreamingLevelActors;
+
+	for (int32 Idx = AlwaysRelevantStreamingLevels.Num() - 1; Idx >= 0; --Idx)
+	{
+		FName StreamingLevel = AlwaysRelevantStreamingLevels[Idx];
+		FActorRepListRefView* ListPtr = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
+
+		if (ListPtr == nullptr)
+		{
+			AlwaysRelevantStreamingLevels.RemoveAtSwap(Idx, 1, false);
+			continue;
+		}
+
+		FActorRepListRefView& RepList = *ListPtr;
+		if (RepList.Num() > 0)
+		{
+			bool bAllDormant = true;
+			for (FActorRepListType Actor : RepList)
+			{
+				FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+				if (ConnectionActorInfo.bDormantOnConnection == false)
+				{
+					bAllDormant = false;
+					break;
+				}
+			}
+
+			if (bAllDormant == true)
+			{
+				AlwaysRelevantStreamingLevels.RemoveAtSwap(Idx, 1, false);
+			}
+			else
+			{
+				Params.OutGatheredReplicationLists.AddReplicationActorList(RepList);
+			}
+		}
+	}
+
+	RepGraph->GetTracer().RecordNodeGather(this, Params, NumListsBefore);
+
+	// The weapon tier was turned off by DA.ReloadRepPolicies, the weapon goes back to being a dependent actor of its pawn
+	if ((RepGraph->bUseWeaponReplicationTier == false) && (LastViewTargetWeapon != nullptr))
+	{
+		ReplicationActorList.Remove(LastViewTargetWeapon);
+		LastViewTargetWeapon = nullptr;
+	}
+
+	if (RepGraph->bUseWeaponReplicationTier == true)
+	{
+		ADACharacter* ViewTargetPawn = Cast<ADACharacter>(Params.Viewer.ViewTarget);
+		ADAWeapon* ViewTargetWeapon = ViewTargetPawn != nullptr ? ViewTargetPawn->Weapon : nullptr;
+
+		if (ViewTargetWeapon != LastViewTargetWeapon)
+		{
+			if (LastViewTargetWeapon != nullptr)
+			{
+				ReplicationActorList.Remove(LastViewTargetWeapon);
+			}
+
+			LastViewTargetWeapon = ViewTargetWeapon;
+		}
+
+		if (ViewTargetWeapon != nullptr)
+		{
+			ReplicationActorList.ConditionalAdd(ViewTargetWeapon);
+
+			FConnectionReplicationActorInfo& WeaponInfo = ConnectionActorInfoMap.FindOrAdd(ViewTargetWeapon);
+			WeaponInfo.ReplicationPeriodFrame = RepGraph->WeaponOwnerReplicationPeriodFrame;
+			WeaponInfo.CullDistanceSquared = 0.f;
+		}
+	}
+
+#if WITH_GAMEPLAY_DEBUGGER
+	if (GameplayDebugger != NULL)
+	{
+		ReplicationActorList.ConditionalAdd(GameplayDebugger);
+	}
+#endif
+}
+
+#if WITH_GAMEPLAY_DEBUGGER
+void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::SetGameplayDebugger(AGameplayDebuggerCategoryReplicator* Debugger)
+{
+	// The list is only added to while gathering, the previous debugger would otherwise stay relevant to this connection
+	if ((GameplayDebugger != nullptr) && (GameplayDebugger != Debugger))
+	{
+		ReplicationActorList.Remove(GameplayDebugger);
+	}
+
+	GameplayDebugger = Debugger;
+}
+#endif
+
+void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityAdd(FName LevelName, UWorld* LevelWorld)
+{
+	AlwaysRelevantStreamingLevels.Add(LevelName);
+}
+
+void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove(FName LevelName)
+{
+	AlwaysRelevantStreamingLevels.Remove(LevelName);
+}
+
+void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::ResetGameWorldState()
+{
+	AlwaysRelevantStreamingLevels.Reset();
+	LastViewTargetWeapon = nullptr;
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_DensityCull_ForConnection
+
+void UDAReplicationGraphNode_DensityCull_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DADensityCull_Gather);
+
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	if ((RepGraph->DensityCullClasses.Num() == 0) || (RepGraph->IsSpectatorConnection(Params) == true))
+	{
+		return;
+	}
+
+	FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+	const FVector& ViewLocation = Params.Viewer.ViewLocation;
+
+	GatheredPerClass.SetNum(RepGraph->DensityCullClasses.Num());
+	for (TArray<TPair<FActorRepListType, float>>& Gathered : GatheredPerClass)
+	{
+		Gathered.Reset();
+	}
+
+	// Only actors gathered for this connection can be replicated to it. The others keep the cull distance they last
+	// got here, it is written again before they can be replicated
+	for (const FActorRepListConstView& List : Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default))
+	{
+		for (FActorRepListType Actor : List)
+		{
+			if (const int32* ClassIdx = RepGraph->DensityCulledActors.Find(Actor))
+			{
+				GatheredPerClass[*ClassIdx].Emplace(Actor, (Actor->GetActorLocation() - ViewLocation).SizeSquared());
+			}
+		}
+	}
+
+	for (int32 ClassIdx = 0; ClassIdx < GatheredPerClass.Num(); ++ClassIdx)
+	{
+		const FDADensityCullClass& DensityClass = RepGraph->DensityCullClasses[ClassIdx];
+		const TArray<TPair<FActorRepListType, float>>& Gathered = GatheredPerClass[ClassIdx];
+
+		// Count the actors that would pass the class cull distance
+		InRangeDistancesSquared.Reset();
+		if (Gathered.Num() > DensityClass.MaxActorsInRange)
+		{
+			for (const TPair<FActorRepListType, float>& Actor : Gathered)
+			{
+				const float ClassCullDistSq = GlobalActorReplicationInfoMap.Get(Actor.Key).Settings.CullDistanceSquared;
+				if (ClassCullDistSq <= 0.f || Actor.Value <= ClassCullDistSq)
+				{
+					InRangeDistancesSquared.Add(Actor.Value);
+				}
+			}
+		}
+
+		// Over budget, shrink the cull distance so only the closest actors are kept
+		const bool bOverBudget = InRangeDistancesSquared.Num() > DensityClass.MaxActorsInRange;
+		float EffectiveCullDistSq = 0.f;
+		if (bOverBudget == true)
+		{
+			InRangeDistancesSquared.Sort();
+			EffectiveCullDistSq = FMath::Max(InRangeDistancesSquared[DensityClass.MaxActorsInRange - 1], DensityClass.MinCullDistanceSquared);
+
+			INC_DWORD_STAT(STAT_DADensityCull_ConnectionsOverBudget);
+			INC_DWORD_STAT_BY(STAT_DADensityCull_ActorsCulled, InRangeDistancesSquared.Num() - DensityClass.MaxActorsInRange);
+		}
+
+		// Not over budget also restores the class cull distance of actors that were shrunk before
+		for (const TPair<FActorRepListType, float>& Actor : Gathered)
+		{
+			float CullDistSq = GlobalActorReplicationInfoMap.Get(Actor.Key).Settings.CullDistanceSquared;
+			if (bOverBudget == true)
+			{
+				CullDistSq = CullDistSq > 0.f ? FMath::Min(CullDistSq, EffectiveCullDistSq) : EffectiveCullDistSq;
+			}
+
+			ConnectionActorInfoMap.FindOrAdd(Actor.Key).CullDistanceSquared = CullDistSq;
+		}
+	}
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_ViewPriority_ForConnection
+
+void UDAReplicationGraphNode_ViewPriority_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAViewPriority_Gather);
+
+	const UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	if (RepGraph->IsSpectatorConnection(Params) == true)
+	{
+		return;
+	}
+
+	FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+
+	const FVector& ViewLocation = Params.Viewer.ViewLocation;
+	const FVector ViewDir = Params.Viewer.ViewDir.GetSafeNormal();
+	const float ConeCos = FMath::Cos(FMath::DegreesToRadians(RepGraph->ViewPriorityConeHalfAngle));
+	const float NearDistSq = FMath::Square(RepGraph->ViewPriorityNearDistance);
+
+	int32 NumInView = 0;
+	int32 NumOutOfView = 0;
+
+	for (const FActorRepListConstView& List : Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default))
+	{
+		for (FActorRepListType Actor : List)
+		{
+			// Actors owned by the viewer, like its own pawn and anything the pawn owns, are never demoted. Neither is the
+			// weapon of the view target, which already gets the owner weapon tier
+			if (Actor == Params.Viewer.InViewer || Actor == Params.Viewer.ViewTarget || Actor->IsOwnedBy(Params.Viewer.InViewer) == true || Actor->GetOwner() == Params.Viewer.ViewTarget)
+			{
+				continue;
+			}
+
+			const FVector ToActor = Actor->GetActorLocation() - ViewLocation;
+			const float DistSq = ToActor.SizeSquared();
+
+			const bool bInView = DistSq <= NearDistSq || FVector::DotProduct(ToActor, ViewDir) >= ConeCos * FMath::Sqrt(DistSq);
+
+			const float PeriodScale = bInView ? RepGraph->ViewPriorityInViewPeriodScale : RepGraph->ViewPriorityOutOfViewPeriodScale;
+			const uint32 ClassPeriod = GlobalActorReplicationInfoMap.Get(Actor).Settings.ReplicationPeriodFrame;
+
+			FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+			ConnectionActorInfo.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ClassPeriod * PeriodScale), 1);
+
+			if (bInView == true)
+			{
+				++NumInView;
+			}
+			else
+			{
+				++NumOutOfView;
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_DAViewPriority_InView, NumInView);
+	INC_DWORD_STAT_BY(STAT_DAViewPriority_OutOfView, NumOutOfView);
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_GridSpatialization2D
+
+void UDAReplicationGraphNode_GridSpatialization2D::PrepareForReplication()
+{
+	// Runs before the grid places its dynamic actors, so actors that just left the bias are never clamped into the edge cells
+	CastChecked<UDAReplicationGraph>(GetOuter())->UpdateGridOutOfBoundsActors();
+
+	Super::PrepareForReplication();
+}
+
+void UDAReplicationGraphNode_GridSpatialization2D::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+	if (RepGraph->IsSpectatorConnection(Params) == true)
+	{
+		return;
+	}
+
+	const int32 NumListsBefore = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+
+	Super::GatherActorListsForConnection(Params);
+
+	RepGraph->GetTracer().RecordNodeGather(this, Params, NumListsBefore);
+}
+
+void UDAReplicationGraphNode_GridSpatialization2D::GatherWithinRadius(const FVector2D& Center, float Radius, FActorRepListRefView& OutList) const
+{
+	const float RadiusSq = FMath::Square(Radius);
+
+	for (const auto& DynamicActor : DynamicSpatializedActors)
+	{
+		if (FVector2D::DistSquared(FVector2D(DynamicActor.Key->GetActorLocation()), Center) <= RadiusSq)
+		{
+			OutList.Add(DynamicActor.Key);
+		}
+	}
+
+	for (const auto& StaticActor : StaticSpatializedActors)
+	{
+		if (FVector2D::DistSquared(FVector2D(StaticActor.Key->GetActorLocation()), Center) <= RadiusSq)
+		{
+			OutList.Add(StaticActor.Key);
+		}
+	}
+
+	// Static actors waiting for their first placement are not in the map yet
+	for (const FPendingStaticActors& PendingActor : PendingStaticSpatializedActors)
+	{
+		if (FVector2D::DistSquared(FVector2D(PendingActor.Actor->GetActorLocation()), Center) <= RadiusSq)
+		{
+			OutList.Add(PendingActor.Actor);
+		}
+	}
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_Spectator_ForConnection
+
+void UDAReplicationGraphNode_Spectator_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+	if (RepGraph->IsSpectatorConnection(Params) == false)
+	{
+		return;
+	}
+
+	FIntPoint ViewCell;
+	const FDASpectatorView& View = RepGraph->GetSpectatorView(Params.Viewer.ViewLocation, Params.ReplicationFrameNum, ViewCell);
+
+	if ((ViewCell != LastViewCell) || (View.BuildFrame != LastViewBuildFrame))
+	{
+		FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+		FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+
+		const uint32 PeriodScale = (uint32)FMath::Max(RepGraph->SpectatorPeriodScale, 1);
+
+		for (FActorRepListType Actor : View.Actors)
+		{
+			FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+			ConnectionActorInfo.CullDistanceSquared = 0.f;
+			ConnectionActorInfo.ReplicationPeriodFrame = GlobalActorReplicationInfoMap.Get(Actor).Settings.ReplicationPeriodFrame * PeriodScale;
+		}
+
+		LastViewCell = ViewCell;
+		LastViewBuildFrame = View.BuildFrame;
+	}
+
+	const int32 NumListsBefore = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+	Params.OutGatheredReplicationLists.AddReplicationActorList(View.Actors);
+
+	RepGraph->GetTracer().RecordNodeGather(this, Params, NumListsBefore);
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_Team_ForConnection
+
+void UDAReplicationGraphNode_Team_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DATeam_Gather);
+
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	if (RepGraph->IsSpectatorConnection(Params) == true)
+	{
+		return;
+	}
+
+	FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+
+	const ADACharacter* ViewCharacter = Cast<ADACharacter>(Params.Viewer.ViewTarget);
+	if (ViewCharacter == nullptr)
+	{
+		const APlayerController* PlayerController = Cast<APlayerController>(Params.Viewer.InViewer);
+		ViewCharacter = PlayerController != nullptr ? Cast<ADACharacter>(PlayerController->GetPawn()) : nullptr;
+	}
+
+	const uint8 Team = ViewCharacter != nullptr ? ViewCharacter->GetTeam() : ADACharacter::NoTeam;
+
+	// Hand the members of the team we left back to the cull distance check
+	if ((Team != LastTeam) && (RepGraph->TeamMembers.Contains(LastTeam) == true))
+	{
+		for (FActorRepListType Actor : RepGraph->TeamMembers[LastTeam])
+		{
+			const FClassReplicationInfo& Settings = GlobalActorReplicationInfoMap.Get(Actor).Settings;
+
+			FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+			ConnectionActorInfo.CullDistanceSquared = Settings.CullDistanceSquared;
+			ConnectionActorInfo.ReplicationPeriodFrame = Settings.ReplicationPeriodFrame;
+		}
+	}
+
+	LastTeam = Team;
+
+	const FActorRepListRefView* TeamList = RepGraph->TeamMembers.Find(Team);
+	if ((TeamList == nullptr) || (TeamList->Num() == 0))
+	{
+		return;
+	}
+
+	const FVector& ViewLocation = Params.Viewer.ViewLocation;
+	const int32 OutOfRangeScale = FMath::Max(RepGraph->TeamOutOfRangePeriodScale, 1);
+
+	int32 NumOutOfRange = 0;
+
+	for (FActorRepListType Actor : *TeamList)
+	{
+		const FClassReplicationInfo& Settings = GlobalActorReplicationInfoMap.Get(Actor).Settings;
+		const bool bInRange = (Settings.CullDistanceSquared <= 0.f) || ((Actor->GetActorLocation() - ViewLocation).SizeSquared() <= Settings.CullDistanceSquared);
+
+		FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+
+		// Teammates are never culled for their team, not even by the density cull
+		ConnectionActorInfo.CullDistanceSquared = 0.f;
+
+		if (bInRange == false)
+		{
+			ConnectionActorInfo.ReplicationPeriodFrame = Settings.ReplicationPeriodFrame * OutOfRangeScale;
+			++NumOutOfRange;
+		}
+		else if (RepGraph->bEnableViewPriority == false)
+		{
+			// The view priority node already set the period of teammates the grid gathered
+			ConnectionActorInfo.ReplicationPeriodFrame = Settings.ReplicationPeriodFrame;
+		}
+	}
+
+	// Teammates in range were already gathered by the character grid, only hand out the ones it left behind
+	TSet<FActorRepListType, DefaultKeyFuncs<FActorRepListType>, TInlineSetAllocator<64>> GridGatheredMembers;
+	const FActorRepListRefView* GridActors = RepGraph->CharacterGridNode != nullptr ? RepGraph->CharacterGridNode->GetGatheredActors(Params.ConnectionManager, Params.ReplicationFrameNum) : nullptr;
+	if (GridActors != nullptr)
+	{
+		for (FActorRepListType Actor : *GridActors)
+		{
+			// The character grid only holds characters
+			if (static_cast<const ADACharacter*>(Actor)->GetTeam() == Team)
+			{
+				GridGatheredMembers.Add(Actor);
+			}
+		}
+	}
+
+	UngatheredMembers.Reset(TeamList->Num());
+	for (FActorRepListType Actor : *TeamList)
+	{
+		if (GridGatheredMembers.Contains(Actor) == false)
+		{
+			UngatheredMembers.Add(Actor);
+		}
+	}
+
+	if (UngatheredMembers.Num() > 0)
+	{
+		const int32 NumListsBefore = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+		Params.OutGatheredReplicationLists.AddReplicationActorList(UngatheredMembers);
+
+		RepGraph->GetTracer().RecordNodeGather(this, Params, NumListsBefore);
+	}
+
+	INC_DWORD_STAT_BY(STAT_DATeam_OutOfRange, NumOutOfRange);
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_RepListTelemetry_ForConnection
+
+void UDAReplicationGraphNode_RepListTelemetry_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	for (const FActorRepListConstView& List : Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default))
+	{
+		RepGraph->RecordGatheredList(List);
+	}
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_Trace_ForConnection
+
+void UDAReplicationGraphNode_Trace_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	UDAReplicationGraph* RepGraph = CastChecked<UDAReplicationGraph>(GetOuter());
+
+	FDARepGraphTracer& Tracer = RepGraph->GetTracer();
+	if (Tracer.IsRunning() == true)
+	{
+		Tracer.RecordConnectionGather(Params, *GraphGlobals->GlobalActorReplicationInfoMap);
+	}
+
+	FDARepGraphGolden& Golden = RepGraph->GetGolden();
+	if (Golden.IsRunning() == true)
+	{
+		Golden.RecordConnectionGather(Params);
+	}
+}
+
+// --------------------------------------------------
+// FDAPackedGridCell
+
+int32 FDAPackedGridCell::Add(FActorRepListType Actor, const FVector& Location, float InCullDistanceSquared)
+{
+	LocationX.Add(Location.X);
+	LocationY.Add(Location.Y);
+	LocationZ.Add(Location.Z);
+	CullDistanceSquared.Add(InCullDistanceSquared);
+	return Actors.Add(Actor);
+}
+
+void FDAPackedGridCell::RemoveAtSwap(int32 Index)
+{
+	Actors.RemoveAtSwap(Index, 1, false);
+	LocationX.RemoveAtSwap(Index, 1, false);
+	LocationY.RemoveAtSwap(Index, 1, false);
+	LocationZ.RemoveAtSwap(Index, 1, false);
+	CullDistanceSquared.RemoveAtSwap(Index, 1, false);
+}
+
+int32 FDAPackedGridCell::GatherWithinCullDistance(const FVector& ViewLocation, FActorRepListRefView& OutList) const
+{
+	const int32 NumActors = Actors.Num();
+	const int32 NumVectorized = NumActors & ~3;
+	int32 NumGathered = 0;
+
+	const float* RESTRICT X = LocationX.GetData();
+	const float* RESTRICT Y = LocationY.GetData();
+	const float* RESTRICT Z = LocationZ.GetData();
+	const float* RESTRICT CullDistSq = CullDistanceSquared.GetData();
+
+	// VectorRegister maps to SSE or NEON depending on the platform and falls back to scalar math where neither is available
+	const VectorRegister ViewX = VectorSetFloat1(ViewLocation.X);
+	const VectorRegister ViewY = VectorSetFloat1(ViewLocation.Y);
+	const VectorRegister ViewZ = VectorSetFloat1(ViewLocation.Z);
+
+	for (int32 Idx = 0; Idx < NumVectorized; Idx += 4)
+	{
+		const VectorRegister DeltaX = VectorSubtract(VectorLoad(X + Idx), ViewX);
+		const VectorRegister DeltaY = VectorSubtract(VectorLoad(Y + Idx), ViewY);
+		const VectorRegister DeltaZ = VectorSubtract(VectorLoad(Z + Idx), ViewZ);
+
+		VectorRegister DistSq = VectorMultiply(DeltaX, DeltaX);
+		DistSq = VectorMultiplyAdd(DeltaY, DeltaY, DistSq);
+		DistSq = VectorMultiplyAdd(DeltaZ, DeltaZ, DistSq);
+
+		uint32 InRangeMask = (uint32)VectorMaskBits(VectorCompareGE(VectorLoad(CullDistSq + Idx), DistSq));
+		while (InRangeMask != 0)
+		{
+			OutList.Add(Actors[Idx + FMath::CountTrailingZeros(InRangeMask)]);
+			InRangeMask &= InRangeMask - 1;
+			++NumGathered;
+		}
+	}
+
+	for (int32 Idx = NumVectorized; Idx < NumActors; ++Idx)
+	{
+		const float DistSq = FVector(X[Idx], Y[Idx], Z[Idx]).DistSquared(ViewLocation);
+		if (DistSq <= CullDistSq[Idx])
+		{
+			OutList.Add(Actors[Idx]);
+			++NumGathered;
+		}
+	}
+
+	return NumGathered;
+}
+
+// --------------------------------------------------
+// UDAReplicationGraphNode_PackedGrid
+
+UDAReplicationGraphNode_PackedGrid::UDAReplicationGraphNode_PackedGrid()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UDAReplicationGraphNode_PackedGrid::GatherWithinRadius(const FVector2D& Center, float Radius, FActorRepListRefView& OutList) const
+{
+	const float RadiusSq = FMath::Square(Radius);
+
+	// Cells no connection views are refreshed less often, their actors are tested where they were on the last refresh
+	auto GatherCell = [&Center, RadiusSq, &OutList](const FDAPackedGridCell& Cell)
+	{
+		for (int32 Idx = 0; Idx < Cell.Num(); ++Idx)
+		{
+			if (FVector2D::DistSquared(FVector2D(Cell.LocationX[Idx], Cell.LocationY[Idx]), Center) <= RadiusSq)
+			{
+				OutList.Add(Cell.Actors[Idx]);
+			}
+		}
+	};
+
+	const FIntPoint Min = GetCellCoords(FVector(Center.X - Radius, Center.Y - Radius, 0.f)) - GridOrigin;
+	const FIntPoint Max = GetCellCoords(FVector(Center.X + Radius, Center.Y + Radius, 0.f)) - GridOrigin;
+
+	for (int32 ColumnIdx = FMath::Max(Min.X, 0); ColumnIdx <= FMath::Min(Max.X, GridSize.X - 1); ++ColumnIdx)
+	{
+		const TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = FMath::Max(Min.Y, 0); RowIdx <= FMath::Min(Max.Y, GridSize.Y - 1); ++RowIdx)
+		{
+			GatherCell(Column[RowIdx]);
+		}
+	}
+
+	GatherCell(OverflowCell);
+}
+
+SIZE_T UDAReplicationGraphNode_PackedGrid::GetAllocatedSize() const
 {
-	AlwaysRelevantStreamingLevels.Remove(LevelName);
+	auto GetCellSize = [](const FDAPackedGridCell& Cell)
+	{
+		return Cell.Actors.GetAllocatedSize() + Cell.LocationX.GetAllocatedSize() + Cell.LocationY.GetAllocatedSize()
+			+ Cell.LocationZ.GetAllocatedSize() + Cell.CullDistanceSquared.GetAllocatedSize();
+	};
+
+	SIZE_T Bytes = Grid.GetAllocatedSize() + ActorSlots.GetAllocatedSize() + ViewerRanges.GetAllocatedSize() + GetCellSize(OverflowCell);
+
+	for (const TArray<FDAPackedGridCell>& Column : Grid)
+	{
+		Bytes += Column.GetAllocatedSize();
+
+		for (const FDAPackedGridCell& Cell : Column)
+		{
+			Bytes += GetCellSize(Cell);
+		}
+	}
+
+	return Bytes;
 }
 
-void UDAReplicationGraphNode_AlwaysRelevant_ForConnection::ResetGameWorldState()
+void UDAReplicationGraphNode_PackedGrid::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (ActorSlots.Contains(ActorInfo.Actor))
+	{
+		return;
+	}
+
+	const FVector Location = ActorInfo.Actor->GetActorLocation();
+	const FGlobalActorReplicationInfo& GlobalInfo = GraphGlobals->GlobalActorReplicationInfoMap->Get(ActorInfo.Actor);
+	const float CullDistSq = GetPackedCullDistanceSquared(GlobalInfo.Settings.CullDistanceSquared);
+
+	AddToCell(ActorInfo.Actor, GetCellCoords(Location), Location, CullDistSq);
+
+	if (GlobalInfo.Settings.CullDistanceSquared > 0.f)
+	{
+		MaxCullDistance = FMath::Max(MaxCullDistance, FMath::Sqrt(CullDistSq));
+	}
+	else
+	{
+		bHasUnculledActors = true;
+	}
+}
+
+bool UDAReplicationGraphNode_PackedGrid::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	FActorCellSlot Slot;
+	if (ActorSlots.RemoveAndCopyValue(ActorInfo.Actor, Slot) == false)
+	{
+		return false;
+	}
+
+	RemoveFromCell(Slot);
+	return true;
+}
+
+void UDAReplicationGraphNode_PackedGrid::NotifyResetAllNetworkActors()
+{
+	ActorSlots.Reset();
+	Grid.Reset();
+	OverflowCell = FDAPackedGridCell();
+
+	GridOrigin = GridSize = FIntPoint::ZeroValue;
+	PendingMin = PendingMax = FIntPoint::ZeroValue;
+	ViewerRanges.Reset();
+
+	MaxCullDistance = PeriodMaxCullDistSq = 0.f;
+	bHasUnculledActors = bPeriodHasUnculledActors = false;
+}
+
+void UDAReplicationGraphNode_PackedGrid::PrepareForReplication()
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAPackedGrid_PrepareForReplication);
+
+	const uint32 FrameNum = GraphGlobals->ReplicationGraph->GetReplicationGraphFrame();
+	const uint32 UpdatePeriod = (uint32)FMath::Max(UnviewedCellUpdatePeriod, 1);
+
+	if (GrowGrid() == true)
+	{
+		RebuildViewerCounts();
+	}
+
+	ReleaseStaleViewers(FrameNum);
+
+	FCellChangeArray ActorsChangingCell;
+
+	int32 NumSkippedCells = 0;
+	for (int32 ColumnIdx = 0; ColumnIdx < Grid.Num(); ++ColumnIdx)
+	{
+		TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = 0; RowIdx < Column.Num(); ++RowIdx)
+		{
+			FDAPackedGridCell& Cell = Column[RowIdx];
+			if (Cell.Num() == 0)
+			{
+				continue;
+			}
+
+			// Cells nobody is viewing are only updated every few frames, staggered so they don't all update on the same frame
+			if (Cell.NumViewers == 0 && ((FrameNum + ColumnIdx + RowIdx) % UpdatePeriod) != 0)
+			{
+				++NumSkippedCells;
+				continue;
+			}
+
+			RefreshCell(Cell, GridOrigin + FIntPoint(ColumnIdx, RowIdx), FrameNum, ActorsChangingCell);
+		}
+	}
+
+	RefreshCell(OverflowCell, FIntPoint(OverflowCellCoord, OverflowCellCoord), FrameNum, ActorsChangingCell);
+
+	MoveActorsChangingCell(ActorsChangingCell);
+
+	// Every cell has been updated at least once per period, so the max cull distance is only allowed to shrink at the end of one
+	MaxCullDistance = FMath::Max(MaxCullDistance, FMath::Sqrt(PeriodMaxCullDistSq));
+	bHasUnculledActors |= bPeriodHasUnculledActors;
+
+	if ((FrameNum % UpdatePeriod) == 0)
+	{
+		MaxCullDistance = FMath::Sqrt(PeriodMaxCullDistSq);
+		bHasUnculledActors = bPeriodHasUnculledActors;
+
+		PeriodMaxCullDistSq = 0.f;
+		bPeriodHasUnculledActors = false;
+	}
+
+	// Summed over the packed and the character grid
+	INC_DWORD_STAT_BY(STAT_DAPackedGrid_Cells, GridSize.X * GridSize.Y);
+	INC_DWORD_STAT_BY(STAT_DAPackedGrid_OverflowActors, OverflowCell.Num());
+	INC_DWORD_STAT_BY(STAT_DAPackedGrid_CellsSkipped, NumSkippedCells);
+}
+
+void UDAReplicationGraphNode_PackedGrid::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAPackedGrid_Gather);
+
+	if ((ActorSlots.Num() == 0) || (CastChecked<UDAReplicationGraph>(GetOuter())->IsSpectatorConnection(Params) == true))
+	{
+		return;
+	}
+
+	const FVector& ViewLocation = Params.Viewer.ViewLocation;
+
+	// Absolute cell range the viewer can see actors in
+	FIntPoint ViewMin = GridOrigin;
+	FIntPoint ViewMax = GridOrigin + GridSize - FIntPoint(1, 1);
+
+	if (bHasUnculledActors == false)
+	{
+		ViewMin = GetCellCoords(ViewLocation - FVector(MaxCullDistance, MaxCullDistance, 0.f));
+		ViewMax = GetCellCoords(ViewLocation + FVector(MaxCullDistance, MaxCullDistance, 0.f));
+	}
+
+	// The viewer keeps one extra cell around its range awake so actors moving towards it are up to date when they get in range
+	UpdateViewerRange(&Params.ConnectionManager, ViewMin - FIntPoint(1, 1), ViewMax + FIntPoint(1, 1), Params.ReplicationFrameNum);
+
+	const int32 MinX = FMath::Max(ViewMin.X - GridOrigin.X, 0);
+	const int32 MinY = FMath::Max(ViewMin.Y - GridOrigin.Y, 0);
+	const int32 MaxX = FMath::Min(ViewMax.X - GridOrigin.X, GridSize.X - 1);
+	const int32 MaxY = FMath::Min(ViewMax.Y - GridOrigin.Y, GridSize.Y - 1);
+
+
+	// Cells that had no viewers were skipped this frame, catch them up and move the actors that left them before
+	// testing any cell, so an actor that moved into a cell of the range is found in that cell
+	FCellChangeArray ActorsChangingCell;
+	for (int32 ColumnIdx = MinX; ColumnIdx <= MaxX; ++ColumnIdx)
+	{
+		TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = MinY; RowIdx <= MaxY; ++RowIdx)
+		{
+			FDAPackedGridCell& Cell = Column[RowIdx];
+			if ((Cell.Num() > 0) && (Cell.LastUpdateFrame != Params.ReplicationFrameNum))
+			{
+				RefreshCell(Cell, GridOrigin + FIntPoint(ColumnIdx, RowIdx), Params.ReplicationFrameNum, ActorsChangingCell);
+			}
+		}
+	}
+
+	MoveActorsChangingCell(ActorsChangingCell);
+
+	// Sized by the actors the viewed cells can give, not by the whole grid, so a large grid does not take a list
+	// far above the pre-allocated pool sizes for a viewer that only sees a few cells
+	int32 NumInRange = OverflowCell.Num();
+	for (int32 ColumnIdx = MinX; ColumnIdx <= MaxX; ++ColumnIdx)
+	{
+		TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = MinY; RowIdx <= MaxY; ++RowIdx)
+		{
+			NumInRange += Column[RowIdx].Num();
+		}
+	}
+
+	GatheredActors.Reset(NumInRange);
+
+	int32 NumTested = 0;
+	for (int32 ColumnIdx = MinX; ColumnIdx <= MaxX; ++ColumnIdx)
+	{
+		TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = MinY; RowIdx <= MaxY; ++RowIdx)
+		{
+			FDAPackedGridCell& Cell = Column[RowIdx];
+			if (Cell.Num() > 0)
+			{
+				Cell.GatherWithinCullDistance(ViewLocation, GatheredActors);
+				NumTested += Cell.Num();
+			}
+		}
+	}
+
+	if (OverflowCell.Num() > 0)
+	{
+		OverflowCell.GatherWithinCullDistance(ViewLocation, GatheredActors);
+		NumTested += OverflowCell.Num();
+	}
+
+	INC_DWORD_STAT_BY(STAT_DAPackedGrid_ActorsTested, NumTested);
+	INC_DWORD_STAT_BY(STAT_DAPackedGrid_ActorsGathered, GatheredActors.Num());
+
+	if (GatheredActors.Num() > 0)
+	{
+		GatheredConnection = &Params.ConnectionManager;
+		GatheredFrame = Params.ReplicationFrameNum;
+
+		const int32 NumListsBefore = Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default).Num();
+		Params.OutGatheredReplicationLists.AddReplicationActorList(GatheredActors);
+
+		CastChecked<UDAReplicationGraph>(GetOuter())->GetTracer().RecordNodeGather(this, Params, NumListsBefore);
+	}
+}
+
+void UDAReplicationGraphNode_PackedGrid::RefreshCell(FDAPackedGridCell& Cell, const FIntPoint& CellCoords, uint32 FrameNum, FCellChangeArray& OutActorsChangingCell)
+{
+	FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+
+	for (int32 Idx = 0; Idx < Cell.Num(); ++Idx)
+	{
+		FGlobalActorReplicationInfo& GlobalInfo = GlobalActorReplicationInfoMap.Get(Cell.Actors[Idx]);
+
+		const FVector Location = Cell.Actors[Idx]->GetActorLocation();
+		GlobalInfo.WorldLocation = Location;
+
+		Cell.LocationX[Idx] = Location.X;
+		Cell.LocationY[Idx] = Location.Y;
+		Cell.LocationZ[Idx] = Location.Z;
+		Cell.CullDistanceSquared[Idx] = GetPackedCullDistanceSquared(GlobalInfo.Settings.CullDistanceSquared);
+
+		if (GlobalInfo.Settings.CullDistanceSquared > 0.f)
+		{
+			PeriodMaxCullDistSq = FMath::Max(PeriodMaxCullDistSq, GlobalInfo.Settings.CullDistanceSquared);
+		}
+		else
+		{
+			bPeriodHasUnculledActors = true;
+		}
+
+		// Actors in the overflow cell move as soon as their cell has been allocated
+		FIntPoint Coords = GetCellCoords(Location);
+		if (IsInGrid(Coords) == false)
+		{
+			RequestGrowth(Coords);
+			Coords = FIntPoint(OverflowCellCoord, OverflowCellCoord);
+		}
+
+		if (Coords != CellCoords)
+		{
+			OutActorsChangingCell.Emplace(Cell.Actors[Idx], Coords);
+		}
+	}
+
+	Cell.LastUpdateFrame = FrameNum;
+}
+
+void UDAReplicationGraphNode_PackedGrid::MoveActorsChangingCell(const FCellChangeArray& ActorsChangingCell)
+{
+	for (const TPair<FActorRepListType, FIntPoint>& Change : ActorsChangingCell)
+	{
+		FActorCellSlot Slot = ActorSlots.FindChecked(Change.Key);
+		FDAPackedGridCell& OldCell = GetSlotCell(Slot.CellX, Slot.CellY);
+
+		const FVector Location(OldCell.LocationX[Slot.Index], OldCell.LocationY[Slot.Index], OldCell.LocationZ[Slot.Index]);
+		const float CullDistSq = OldCell.CullDistanceSquared[Slot.Index];
+
+		RemoveFromCell(Slot);
+		AddToCell(Change.Key, Change.Value, Location, CullDistSq);
+	}
+}
+
+void UDAReplicationGraphNode_PackedGrid::UpdateViewerRange(const UNetReplicationGraphConnection* Connection, const FIntPoint& Min, const FIntPoint& Max, uint32 FrameNum)
+{
+	FViewerRange* Range = ViewerRanges.Find(Connection);
+	if (Range == nullptr)
+	{
+		ViewerRanges.Add(Connection, FViewerRange{ Min, Max, FrameNum });
+		AddViewerCount(Min, Max, 1);
+		return;
+	}
+
+	Range->LastGatherFrame = FrameNum;
+
+	if (Range->Min != Min || Range->Max != Max)
+	{
+		AddViewerCount(Range->Min, Range->Max, -1);
+		AddViewerCount(Min, Max, 1);
+
+		Range->Min = Min;
+		Range->Max = Max;
+	}
+}
+
+void UDAReplicationGraphNode_PackedGrid::ReleaseStaleViewers(uint32 FrameNum)
+{
+	// Connections that stopped gathering have been closed or are not replicating, they no longer keep cells awake
+	for (auto It = ViewerRanges.CreateIterator(); It; ++It)
+	{
+		if (FrameNum - It.Value().LastGatherFrame > StaleViewerFrames)
+		{
+			AddViewerCount(It.Value().Min, It.Value().Max, -1);
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UDAReplicationGraphNode_PackedGrid::AddViewerCount(const FIntPoint& Min, const FIntPoint& Max, int32 Delta)
+{
+	const int32 MinX = FMath::Max(Min.X - GridOrigin.X, 0);
+	const int32 MinY = FMath::Max(Min.Y - GridOrigin.Y, 0);
+	const int32 MaxX = FMath::Min(Max.X - GridOrigin.X, GridSize.X - 1);
+	const int32 MaxY = FMath::Min(Max.Y - GridOrigin.Y, GridSize.Y - 1);
+
+	for (int32 ColumnIdx = MinX; ColumnIdx <= MaxX; ++ColumnIdx)
+	{
+		TArray<FDAPackedGridCell>& Column = Grid[ColumnIdx];
+		for (int32 RowIdx = MinY; RowIdx <= MaxY; ++RowIdx)
+		{
+			Column[RowIdx].NumViewers += Delta;
+		}
+	}
+}
+
+void UDAReplicationGraphNode_PackedGrid::RebuildViewerCounts()
+{
+	for (TArray<FDAPackedGridCell>& Column : Grid)
+	{
+		for (FDAPackedGridCell& Cell : Column)
+		{
+			Cell.NumViewers = 0;
+		}
+	}
+
+	for (const TPair<const UNetReplicationGraphConnection*, FViewerRange>& Pair : ViewerRanges)
+	{
+		AddViewerCount(Pair.Value.Min, Pair.Value.Max, 1);
+	}
+}
+
+FIntPoint UDAReplicationGraphNode_PackedGrid::GetCellCoords(const FVector& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - SpatialBias.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - SpatialBias.Y) / CellSize);
+	return FIntPoint(X, Y);
+}
+
+bool UDAReplicationGraphNode_PackedGrid::IsInGrid(const FIntPoint& Coords) const
 {
-	AlwaysRelevantStreamingLevels.Empty();
+	const FIntPoint Local = Coords - GridOrigin;
+	return Local.X >= 0 && Local.Y >= 0 && Local.X < GridSize.X && Local.Y < GridSize.Y;
+}
+
+FDAPackedGridCell& UDAReplicationGraphNode_PackedGrid::GetSlotCell(int32 CellX, int32 CellY)
+{
+	if (CellX == OverflowCellCoord)
+	{
+		return OverflowCell;
+	}
+
+	return Grid[CellX - GridOrigin.X][CellY - GridOrigin.Y];
+}
+
+bool UDAReplicationGraphNode_PackedGrid::RequestGrowth(const FIntPoint& Coords)
+{
+	// The first actor decides where the grid starts
+	if (GridSize.X == 0 || GridSize.Y == 0)
+	{
+		GridOrigin = PendingMin = PendingMax = Coords;
+		GridSize = FIntPoint(1, 1);
+
+		Grid.SetNum(1);
+		Grid[0].SetNum(1);
+
+		RebuildViewerCounts();
+		return true;
+	}
+
+	const FIntPoint NewMin(FMath::Min(PendingMin.X, Coords.X), FMath::Min(PendingMin.Y, Coords.Y));
+	const FIntPoint NewMax(FMath::Max(PendingMax.X, Coords.X), FMath::Max(PendingMax.Y, Coords.Y));
+
+	if ((int64)NewMax.X - NewMin.X >= MaxCellsPerAxis || (int64)NewMax.Y - NewMin.Y >= MaxCellsPerAxis)
+	{
+		return false;
+	}
+
+	PendingMin = NewMin;
+	PendingMax = NewMax;
+	return true;
+}
+
+bool UDAReplicationGraphNode_PackedGrid::GrowGrid()
+{
+	if (GridSize.X == 0 || GridSize.Y == 0)
+	{
+		return false;
+	}
+
+	int32 NumNewCells = 0;
+
+	// Always add at least one row or column per frame so the grid can't stall on a tiny budget
+	while (NumNewCells == 0 || NumNewCells < MaxNewCellsPerFrame)
+	{
+		const FIntPoint GridMax = GridOrigin + GridSize - FIntPoint(1, 1);
+
+		if (GridOrigin.X > PendingMin.X)
+		{
+			Grid.InsertDefaulted(0, 1);
+			Grid[0].SetNum(GridSize.Y);
+
+			--GridOrigin.X;
+			++GridSize.X;
+			NumNewCells += GridSize.Y;
+		}
+		else if (GridMax.X < PendingMax.X)
+		{
+			Grid.AddDefaulted(1);
+			Grid.Last().SetNum(GridSize.Y);
+
+			++GridSize.X;
+			NumNewCells += GridSize.Y;
+		}
+		else if (GridOrigin.Y > PendingMin.Y)
+		{
+			for (TArray<FDAPackedGridCell>& Column : Grid)
+			{
+				Column.InsertDefaulted(0, 1);
+			}
+
+			--GridOrigin.Y;
+			++GridSize.Y;
+			NumNewCells += GridSize.X;
+		}
+		else if (GridMax.Y < PendingMax.Y)
+		{
+			for (TArray<FDAPackedGridCell>& Column : Grid)
+			{
+				Column.AddDefaulted(1);
+			}
+
+			++GridSize.Y;
+			NumNewCells += GridSize.X;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return NumNewCells > 0;
+}
+
+void UDAReplicationGraphNode_PackedGrid::AddToCell(FActorRepListType Actor, const FIntPoint& Coords, const FVector& Location, float CullDistSq)
+{
+	FIntPoint CellCoords = Coords;
+	if (CellCoords.X != OverflowCellCoord && IsInGrid(CellCoords) == false)
+	{
+		// An empty grid is allocated right away, anything else waits in the overflow cell until the grid has grown
+		RequestGrowth(CellCoords);
+		if (IsInGrid(CellCoords) == false)
+		{
+			CellCoords = FIntPoint(OverflowCellCoord, OverflowCellCoord);
+		}
+	}
+
+	FDAPackedGridCell& Cell = GetSlotCell(CellCoords.X, CellCoords.Y);
+
+	FActorCellSlot& Slot = ActorSlots.FindOrAdd(Actor);
+	Slot.CellX = CellCoords.X;
+	Slot.CellY = CellCoords.Y;
+	Slot.Index = Cell.Add(Actor, Location, CullDistSq);
+}
+
+void UDAReplicationGraphNode_PackedGrid::RemoveFromCell(const FActorCellSlot& Slot)
+{
+	FDAPackedGridCell& Cell = GetSlotCell(Slot.CellX, Slot.CellY);
+
+	// The last actor of the cell is swapped into the removed slot
+	const int32 LastIndex = Cell.Num() - 1;
+	if (Slot.Index != LastIndex)
+	{
+		ActorSlots.FindChecked(Cell.Actors[LastIndex]).Index = Slot.Index;
+	}
+
+	Cell.RemoveAtSwap(Slot.Index);
 }
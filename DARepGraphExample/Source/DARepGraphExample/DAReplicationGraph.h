@@ -22,32 +22,151 @@
 
 #include "CoreMinimal.h"
 #include "ReplicationGraph.h"
+#include "DAClassRepPolicy.h"
+#include "DACharacter.h"
+#include "DARepGraphTrace.h"
+#include "DARepGraphGolden.h"
 #include "DAReplicationGraph.generated.h"
 
-enum class EClassRepPolicy : uint8
-{
-	NotRouted,
-	RelevantAllConnections,
-
-	// --------------------------------
-	// Spatialized routes into the grid node
-
-	Spatialize_Static,		// Used for actors for frequent updates / updates every frame
-	Spatialize_Dynamic,		// For do need updates every frame
-	Spatialize_Dormancy		// Actors that can either be Static or Dynamic determined by their AActor::NetDormancy state
-};
+DECLARE_STATS_GROUP(TEXT("DAReplicationGraph"), STATGROUP_DAReplicationGraph, STATCAT_Advanced);
 
 class UReplicationGraphNode_ActorList;
 class UReplicationGraphNode_GridSpatialization2D;
 class UReplicationGraphNode_AlwaysRelevant_ForConnection;
+class UDAReplicationGraphNode_PackedGrid;
 class AGameplayDebuggerCategoryReplicator;
 
+/** Limits how many actors of a class a connection replicates at full cull distance when an area gets crowded */
+USTRUCT()
+struct FDADensityCullRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	FSoftClassPath ActorClass;
+
+	/** The closest actors up to this count keep the class cull distance, the rest get culled */
+	UPROPERTY(config)
+	int32 MaxActorsInRange = 16;
+
+	/** The cull distance is never shrunk below this */
+	UPROPERTY(config)
+	float MinCullDistance = 5000.f;
+};
+
+/** Routing and replication info overrides for a class and its subclasses, replaces the class scan for that class */
+USTRUCT()
+struct FDAClassPolicyRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	FSoftClassPath ActorClass;
+
+	/** If false the class keeps the policy of its parent class or of the class scan */
+	UPROPERTY(config)
+	bool bSetPolicy = false;
+
+	UPROPERTY(config)
+	EClassRepPolicy Policy = EClassRepPolicy::Spatialize_Dynamic;
+
+	/** Replaces the cull distance of the class defaults when above 0 */
+	UPROPERTY(config)
+	float CullDistance = 0.f;
+
+	/** Replaces the replication period derived from the class NetUpdateFrequency when above 0 */
+	UPROPERTY(config)
+	int32 ReplicationPeriodFrame = 0;
+
+	bool HasClassInfo() const { return (CullDistance > 0.f) || (ReplicationPeriodFrame > 0); }
+};
+
+/** What the class scan read from the class defaults of one replicated class, cached between starts of a cooked build */
+struct FDAScannedClass
+{
+	UClass* Class = nullptr;
+
+	/** Same relevancy flags as the super class, the class keeps the policy of its parent */
+	bool bSameRelevancyAsSuper = false;
+
+	/** Not spatialized while its super class is */
+	bool bNonSpatialized = false;
+
+	bool bHasRule = false;
+	EClassRepPolicy Rule = EClassRepPolicy::NotRouted;
+
+	float NetCullDistanceSquared = 0.f;
+	float NetUpdateFrequency = 0.f;
+};
+
+/** Runtime state of a FDADensityCullRule */
+struct FDADensityCullClass
+{
+	UClass* Class = nullptr;
+	int32 MaxActorsInRange = 16;
+	float MinCullDistanceSquared = 0.f;
+};
+
+/** Actors around one coarse cell, gathered once and shared by every spectator viewing from that cell */
+struct FDASpectatorView
+{
+	FActorRepListRefView Actors;
+
+	/** Replication frame the list was gathered on */
+	uint32 BuildFrame = 0;
+	uint32 LastUsedFrame = 0;
+
+	/** Number of entries of the graph's removed spectator actors already taken out of the list */
+	int32 NumRemovalsApplied = 0;
+};
+
+/** A movable actor of the main grid, checked for crossing the grid bias when its check bucket comes up */
+struct FDAGridMovableActor
+{
+	EClassRepPolicy Policy = EClassRepPolicy::Spatialize_Dynamic;
+	int32 CheckBucket = INDEX_NONE;
+};
+
+/** Rep list usage of one list size of the rep list pool */
+struct FDARepListBucket
+{
+	int32 ListSize = 0;
+
+	/** Lists pre-allocated for this size, the most any map played by this graph asked for */
+	int32 PreallocatedLists = 0;
+
+	/**
+	 * Most lists of this size held from the pool at once on the current map. Lists are seen through the connection
+	 * gathers, a list of a node nobody gathers from is not counted
+	 */
+	int32 PeakLists = 0;
+
+	/** Lists of this size currently held from the pool */
+	int32 LiveLists = 0;
+};
+
+/** A pool list seen in a connection gather */
+struct FDALiveRepList
+{
+	/** Index of the bucket in the graph's RepListBuckets, the bucket count for lists bigger than every bucket */
+	int32 BucketIdx = 0;
+
+	uint32 LastGatherFrame = 0;
+};
+
 /**
  * 
  */
 UCLASS(Transient, config=Engine)
 class DAREPGRAPHEXAMPLE_API UDAReplicationGraph : public UReplicationGraph
 {
+	// Connection nodes read the graph settings
+	friend class UDAReplicationGraphNode_AlwaysRelevant_ForConnection;
+	friend class UDAReplicationGraphNode_ViewPriority_ForConnection;
+	friend class UDAReplicationGraphNode_Team_ForConnection;
+	friend class UDAReplicationGraphNode_Spectator_ForConnection;
+	friend class UDAReplicationGraphNode_GridSpatialization2D;
+
 public:
 
 	GENERATED_BODY()
@@ -59,11 +178,54 @@ public:
 	virtual void InitGlobalGraphNodes() override;
 	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
 	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+	virtual void SetRepDriverWorld(UWorld* InWorld) override;
 	// ~ end UReplicationGraph
 
+	// ~ begin UObject implementation
+	virtual void BeginDestroy() override;
+	// ~ end UObject
+
+	/** Spectators and replay recorders get the spectator profile instead of the player nodes */
+	bool IsSpectatorConnection(const FConnectionGatherActorListParameters& Params) const;
+
+	/** The shared spectator gather for a view location, rebuilt when it is older than SpectatorGatherPeriod */
+	const FDASpectatorView& GetSpectatorView(const FVector& ViewLocation, uint32 FrameNum, FIntPoint& OutCell);
+
+	/** Decision trace of the gathers and sends, see DA.RepGraphTrace */
+	FDARepGraphTracer& GetTracer() { return Tracer; }
+
+	/** Golden recording and comparison of the gathered sets, see DA.RepGraphGolden */
+	FDARepGraphGolden& GetGolden() { return Golden; }
+
+	float GetGoldenTimeTolerance() const { return GoldenTimeTolerance; }
+
+	/** Counts a list gathered for a connection towards the rep list profile, a pool list read by several connections or frames is counted once */
+	void RecordGatheredList(const FActorRepListConstView& List);
+
+	/**
+	 * Writes the estimated memory used by the graph's actor info maps, nodes and rep lists to Ar and updates the memory stats
+	 *
+	 * The sizes are estimates from element counts, the engine containers do not report their allocations.
+	 */
+	void ReportMemory(FOutputDevice& Ar, bool bPerClass, bool bPerConnection);
+
+	/**
+	 * Re-reads the class policy rules, density cull rules, weapon tier and grid settings from the engine config and applies
+	 * them to the running graph
+	 *
+	 * Actors whose class changed policy are moved between nodes and every actor gets the new class replication info.
+	 * Per connection values set by the connection nodes are kept, the nodes derive them from the new class info.
+	 * Grid cell size and bias only apply on the next start, the grid node can not be re-celled with actors in it.
+	 */
+	void ReloadClassPolicies(FOutputDevice& Ar);
+
 	/** Sets class replication info for a class */
 	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* InClass, bool bSpatilize, float ServerMaxTickRate);
 
+	/** Sets class replication info from the class default values read by the class scan */
+	static void InitClassReplicationInfo(FClassReplicationInfo& Info, float NetCullDistanceSquared, float NetUpdateFrequency, bool bSpatilize, float ServerMaxTickRate);
+
 	UPROPERTY()
 	TArray<UClass*> SpatializedClasses;
 	
@@ -88,11 +250,51 @@ public:
 	UPROPERTY()
 	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
 
+	/** Spatializes Spatialize_Packed actors and culls them per cell before they reach the per-actor distance check */
+	UPROPERTY()
+	UDAReplicationGraphNode_PackedGrid* PackedGridNode;
+
+	/** Spatializes Spatialize_Character actors, a packed grid sized for character cull distances */
+	UPROPERTY()
+	UDAReplicationGraphNode_PackedGrid* CharacterGridNode;
+
 	/** Maps the actors the needs to be always relevant across streaming levels */
 	TMap<FName, FActorRepListRefView> AlwaysRelevantStreamingLevelActors;
 
+	/** Classes that get their cull distance shrunk per connection when too many of them are in range */
+	TArray<FDADensityCullClass> DensityCullClasses;
+
+	/** Replicated actors of the density culled classes, to their index in DensityCullClasses */
+	TMap<FActorRepListType, int32> DensityCulledActors;
+
+	/** Movable actors of the main grid, only tracked when actors below the grid bias go to the packed grid */
+	TMap<FActorRepListType, FDAGridMovableActor> GridMovableActors;
+
+	static const int32 GridCheckBucketCount = 32;
+
+	/**
+	 * Movable actors by the frame they get checked against the grid bias next, modulo GridCheckBucketCount.
+	 * Actors far from the bias can not reach it for a while and are checked less often
+	 */
+	TArray<FActorRepListType> GridCheckBuckets[GridCheckBucketCount];
+
+	/** Main grid actors that are below the grid bias and currently live in the packed grid */
+	TSet<FActorRepListType> GridOutOfBoundsActors;
+
+	/** The replicated characters of every team */
+	TMap<uint8, FActorRepListRefView> TeamMembers;
+
+	/** Shared spectator gathers by coarse cell */
+	TMap<FIntPoint, FDASpectatorView> SpectatorViews;
+
+	/** Actors removed from the graph since the oldest spectator view was built, taken out of a view when it is next used */
+	TArray<FActorRepListType> SpectatorRemovedActors;
+
 protected:
 
+	FDARepGraphTracer Tracer;
+	FDARepGraphGolden Golden;
+
 	/** Gets the connection always relevant node from a player controller */
 	class UDAReplicationGraphNode_AlwaysRelevant_ForConnection* GetAlwaysRelevantNode(APlayerController* PlayerController);
 
@@ -103,21 +305,268 @@ protected:
 	UFUNCTION()
 	void OnCharacterNewWeapon(class ADACharacter* Pawn, class ADAWeapon* NewWeapon, class ADAWeapon* OldWeapon);
 
+	void OnCharacterTeamChanged(class ADACharacter* Pawn, uint8 OldTeam, uint8 NewTeam);
+
+	void AddTeamMember(FActorRepListType Actor, uint8 Team);
+	void RemoveTeamMember(FActorRepListType Actor, uint8 Team);
+
 	FORCEINLINE bool IsSpatialized(EClassRepPolicy Mapping)
 	{
 		return Mapping >= EClassRepPolicy::Spatialize_Static;
 	}
 
+	/** Sets the class rules and class replication infos, scanning the loaded classes */
+	void InitClassPolicies();
+
+	/** Loads the classes of the density cull rules */
+	void InitDensityCullClasses();
+
+	/** Reads the relevancy flags, cull distance and update frequency of every loaded replicated class */
+	void ScanReplicatedClasses(TArray<FDAScannedClass>& OutClasses) const;
+
+	/**
+	 * Key of the class scan cache, built from the build, the cooked content and the names of the loaded actor classes.
+	 * Empty when the cache is not used
+	 */
+	FString GetClassScanCacheKey() const;
+
+	/** Loads the cached class scan, fails if there is none, it was saved with another key or one of its classes is not loaded */
+	bool LoadClassScanCache(const FString& Key, TArray<FDAScannedClass>& OutClasses) const;
+	void SaveClassScanCache(const FString& Key, const TArray<FDAScannedClass>& Classes) const;
+
+	static FString GetClassScanCacheFilename();
+
+	/** Adds an actor to the nodes of a policy, or removes it from them */
+	void AddActorToPolicyNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepPolicy MappingPolicy);
+	void RemoveActorFromPolicyNodes(const FNewReplicatedActorInfo& ActorInfo, EClassRepPolicy MappingPolicy);
+
+	/** Adds an actor to the main grid, or to the packed grid when it is below the grid bias and the grid can not be rebuilt */
+	void AddActorToGrid(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepPolicy MappingPolicy);
+	void RemoveActorFromGrid(const FNewReplicatedActorInfo& ActorInfo, EClassRepPolicy MappingPolicy);
+
+	/** Moves the movable main grid actors that left the grid bias into the packed grid, and back once they are inside again */
+	void UpdateGridOutOfBoundsActors();
+
+	/** Puts the actor in the check bucket of the first frame it could cross the grid bias on */
+	void ScheduleGridBoundsCheck(FActorRepListType Actor, FDAGridMovableActor& MovableActor, const FVector& Location, bool bOutOfBounds);
+
+	/** True if actors below the grid bias are handed to the packed grid instead of being clamped into the edge cells */
+	FORCEINLINE bool UsesGridOverflow() const
+	{
+		return (bDisableSpatialRebuilding == true) && (PackedGridNode != nullptr);
+	}
+
 	/** Gets the mapping to used for the given class */
 	EClassRepPolicy GetMappingPolicy(const UClass* InClass);
 
+	/** Gets the policy actors of the class are routed with, the declared policy of a native class without a class map lookup */
+	FORCEINLINE EClassRepPolicy GetRoutePolicy(const UClass* InClass)
+	{
+		for (const TPair<UClass*, EClassRepPolicy>& NativePolicy : NativeRoutePolicies)
+		{
+			if (NativePolicy.Key == InClass)
+			{
+				return NativePolicy.Value;
+			}
+		}
+
+		return GetMappingPolicy(InClass);
+	}
+
+	/** Gets the density cull state for the given class, or null if the class is not density culled */
+	FDADensityCullClass* FindDensityCullClass(const UClass* InClass);
+
 	/** Maps a class to a mapping policy */
 	TClassMap<EClassRepPolicy> ClassRepPolicies;
 
+	/** Rules of the native classes that declare their policy at compile time */
+	void GetNativeClassRules(TArray<TPair<UClass*, EClassRepPolicy>>& OutRules) const;
+
+	/** Policy of each native class by exact class, a handful of entries checked before the class map on every route */
+	TArray<TPair<UClass*, EClassRepPolicy>, TInlineAllocator<8>> NativeRoutePolicies;
+
+	template<typename T>
+	static void AddNativeClassRule(TArray<TPair<UClass*, EClassRepPolicy>>& OutRules)
+	{
+		static_assert(TDAClassRepPolicy<T>::bDeclared == true, "The class has no DA_DECLARE_CLASS_REP_POLICY");
+		static_assert(TIsDerivedFrom<T, AActor>::IsDerived, "Only actors are routed by the replication graph");
+
+		OutRules.Emplace(T::StaticClass(), TDAClassRepPolicy<T>::Policy);
+	}
+
+	/** Pre-allocates the rep list pool from the profile saved for the world's map, or from the defaults if there is none */
+	void PreAllocateRepListsFromProfile(UWorld* World);
+
+	/** Saves the peak rep list usage of this session to the profile of the current map */
+	void SaveRepListProfile();
+
+	/** Rep list memory pre-allocated from the profile */
+	SIZE_T RepListPreallocatedBytes = 0;
+
+	/** Releases the lists that have not been gathered for RepListLiveFrames and updates the rep list peaks */
+	void FlushRepListFrame();
+
+	static FString GetRepListProfileFilename();
+
+	TArray<FDARepListBucket> RepListBuckets;
+
+	/** Pool lists held by the nodes, by the address of their actors which a pool list keeps for its whole life */
+	TMap<const FActorRepListType*, FDALiveRepList> LiveRepLists;
+
+	/** The pool does not say when a list is released, a list nobody gathered for this many frames counts as released */
+	static const uint32 RepListLiveFrames = 30;
+
+	/** The map the rep list profile is loaded from and saved to */
+	FString RepListProfileMap;
+
+	UPROPERTY(config)
 	float GridCellSize = 10000.f;			// The size of one grid cell in the grid node
+
+	UPROPERTY(config)
 	float SpatialBiasX = -150000.f;			// "Min X" for replication
+
+	UPROPERTY(config)
 	float SpatialBiasY = -200000.f;			// "Min Y" for replication
+
+	UPROPERTY(config)
 	bool bDisableSpatialRebuilding = true;
+
+	/**
+	 * Fastest an actor of the main grid is expected to move per replication frame. Decides how often actors are
+	 * checked for crossing the grid bias, an actor teleporting faster stays clamped into the edge cells until its check
+	 */
+	UPROPERTY(config)
+	float GridBoundsCheckMaxMovePerFrame = 500.f;
+
+	/**
+	 * Reuse the class scan of the last start while the build, the cooked content and the loaded actor classes are the same.
+	 * Only used with cooked data, class defaults of blueprints change in the editor without a new build
+	 */
+	UPROPERTY(config)
+	bool bUseClassScanCache = true;
+
+	/** Class routing and replication info overrides, applied on top of the engine and native class rules. See DA.ReloadRepPolicies */
+	UPROPERTY(config)
+	TArray<FDAClassPolicyRule> ClassPolicyRules;
+
+	/** If false, Spatialize_Packed actors are routed to the regular grid node as dynamic actors */
+	UPROPERTY(config)
+	bool bUsePackedGrid = true;
+
+	/** The size of one cell in the packed grid node. Should be close to the cull distance of the actors routed into it */
+	UPROPERTY(config)
+	float PackedGridCellSize = 5000.f;
+
+	/** How many cells the packed grid may allocate per frame when actors leave its current bounds */
+	UPROPERTY(config)
+	int32 PackedGridMaxNewCellsPerFrame = 256;
+
+	UPROPERTY(config)
+	int32 PackedGridMaxCellsPerAxis = 512;
+
+	/** Packed grid cells that no connection is viewing are only updated every this many frames */
+	UPROPERTY(config)
+	int32 PackedGridUnviewedCellUpdatePeriod = 8;
+
+	/** If false, Spatialize_Character actors are routed to the regular grid node as dynamic actors */
+	UPROPERTY(config)
+	bool bUseCharacterGrid = true;
+
+	/** The size of one cell in the character grid node, grows with the character cull distance */
+	UPROPERTY(config)
+	float CharacterGridCellSize = 20000.f;
+
+	/** Characters move all the time, cells nobody views are refreshed more often than in the packed grid */
+	UPROPERTY(config)
+	int32 CharacterGridUnviewedCellUpdatePeriod = 4;
+
+	UPROPERTY(config)
+	TArray<FDADensityCullRule> DensityCullRules;
+
+	/** Replicate actors outside a connection's view cone less often than the ones it is looking at */
+	UPROPERTY(config)
+	bool bEnableViewPriority = false;
+
+	/** Half angle in degrees of the view cone, actors inside it replicate at InViewPeriodScale */
+	UPROPERTY(config)
+	float ViewPriorityConeHalfAngle = 60.f;
+
+	/** Multiplies the replication period of actors inside the view cone. Below 1 replicates them more often, actors replicating every frame stay at every frame */
+	UPROPERTY(config)
+	float ViewPriorityInViewPeriodScale = 0.5f;
+
+	/** Multiplies the replication period of actors outside the view cone */
+	UPROPERTY(config)
+	float ViewPriorityOutOfViewPeriodScale = 3.f;
+
+	/** Actors closer than this to the viewer are always treated as in view */
+	UPROPERTY(config)
+	float ViewPriorityNearDistance = 1500.f;
+
+	/**
+	 * If true weapons are no longer dependent actors of their pawn. The connection viewing the pawn
+	 * gets the weapon at full rate, every other connection only within WeaponCullDistance and less often
+	 */
+	UPROPERTY(config)
+	bool bUseWeaponReplicationTier = true;
+
+	UPROPERTY(config)
+	float WeaponCullDistance = 15000.f;
+
+	/** Multiplies the weapon replication period for connections that are not viewing the weapon's pawn */
+	UPROPERTY(config)
+	int32 WeaponReplicationPeriodScale = 3;
+
+	/** Keep teammates relevant to their team's connections at any distance, enemies stay culled by the grid */
+	UPROPERTY(config)
+	bool bUseTeamRelevancy = true;
+
+	/** Multiplies the replication period of teammates outside their class cull distance */
+	UPROPERTY(config)
+	int32 TeamOutOfRangePeriodScale = 4;
+
+	/** Give spectators and replay connections one shared, coarse and low rate gather instead of the player nodes */
+	UPROPERTY(config)
+	bool bUseSpectatorProfile = true;
+
+	/** Spectators whose view is in the same cell of this size share one gather */
+	UPROPERTY(config)
+	float SpectatorViewCellSize = 50000.f;
+
+	/** Spatialized actors within this distance of the spectator cell center are gathered, class cull distances are ignored */
+	UPROPERTY(config)
+	float SpectatorViewRadius = 100000.f;
+
+	/** A spectator gather is reused for this many frames */
+	UPROPERTY(config)
+	int32 SpectatorGatherPeriod = 8;
+
+	/** Multiplies the replication period of every actor for spectators */
+	UPROPERTY(config)
+	int32 SpectatorPeriodScale = 4;
+
+	/** Multiplies the projectile replication period when projectiles are extrapolated by clients, they force an update when drifting */
+	UPROPERTY(config)
+	int32 ProjectileExtrapolationPeriodScale = 4;
+
+	/** Record the peak rep list usage per map and pre-allocate the rep list pool from it on the next start */
+	UPROPERTY(config)
+	bool bUseRepListProfile = true;
+
+	/** Extra lists pre-allocated on top of the recorded peak */
+	UPROPERTY(config)
+	float RepListProfileHeadroom = 1.25f;
+
+	/** The saved peak decays by this much per session, so a map that got quieter stops pre-allocating for its old peak */
+	UPROPERTY(config)
+	float RepListProfileDecay = 0.75f;
+
+	/** How much slower than the recorded golden run replication may get before a golden comparison fails */
+	UPROPERTY(config)
+	float GoldenTimeTolerance = 1.25f;
+
+	/** Replication period of a weapon for the connection viewing its pawn */
+	uint32 WeaponOwnerReplicationPeriodFrame = 1;
 };
 
 UCLASS()
@@ -137,11 +586,351 @@ public:
 	void ResetGameWorldState();
 
 #if WITH_GAMEPLAY_DEBUGGER
-	AGameplayDebuggerCategoryReplicator* GameplayDebugger = nullptr;
+	AGameplayDebuggerCategoryReplicator* GetGameplayDebugger() const { return GameplayDebugger; }
+	void SetGameplayDebugger(AGameplayDebuggerCategoryReplicator* Debugger);
 #endif
 
 protected:
 
+#if WITH_GAMEPLAY_DEBUGGER
+	AGameplayDebuggerCategoryReplicator* GameplayDebugger = nullptr;
+#endif
+
+	/** The weapon of the view target, replicated at full rate to this connection when using the weapon replication tier */
+	class ADAWeapon* LastViewTargetWeapon = nullptr;
+
 	/** Stores levelstreaming actors */
 	TArray<FName, TInlineAllocator<64>> AlwaysRelevantStreamingLevels;
-};
\ No newline at end of file
+};
+
+/**
+ * Shrinks the cull distance of density culled classes for one connection
+ *
+ * Does not gather any actors itself, it only writes the effective cull distance of the density culled actors the
+ * spatial nodes gathered for the connection to the connection actor infos that the distance check uses later in the frame.
+ */
+UCLASS()
+class UDAReplicationGraphNode_DensityCull_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+
+protected:
+
+	/** Gathered actors and their squared distance to the viewer, per density culled class */
+	TArray<TArray<TPair<FActorRepListType, float>>> GatheredPerClass;
+
+	TArray<float> InRangeDistancesSquared;
+};
+
+/**
+ * Scales the replication period of every actor gathered for a connection by whether it is in the connection's view cone
+ *
+ * Runs after the global nodes and the gathering connection nodes so it sees their lists. The team node comes after it
+ * and sets the period of the teammates it adds itself, the telemetry and trace nodes only read the gathered lists.
+ */
+UCLASS()
+class UDAReplicationGraphNode_ViewPriority_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+};
+
+/** The grid node, skipped by spectators since they get the spectator gather */
+UCLASS()
+class UDAReplicationGraphNode_GridSpatialization2D : public UReplicationGraphNode_GridSpatialization2D
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode_GridSpatialization2D implementation
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode_GridSpatialization2D
+
+	/** Adds every actor of the grid within Radius of Center on the XY plane to OutList */
+	void GatherWithinRadius(const FVector2D& Center, float Radius, FActorRepListRefView& OutList) const;
+};
+
+/**
+ * Gathers the shared spectator view for spectator and replay connections, does nothing for players
+ *
+ * The actors get the class replication period times SpectatorPeriodScale and no cull distance, the view radius
+ * already limits them. Those settings are only written when the shared view was rebuilt, not every frame.
+ */
+UCLASS()
+class UDAReplicationGraphNode_Spectator_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+
+protected:
+
+	/** The shared view the connection settings were last written for */
+	FIntPoint LastViewCell = FIntPoint(MAX_int32, MAX_int32);
+	uint32 LastViewBuildFrame = 0;
+};
+
+/**
+ * Adds the teammates of the connection's view target to its gather, so they are relevant at any distance
+ *
+ * Teammates the grid already gathered keep their rate, the ones outside their cull distance are replicated
+ * TeamOutOfRangePeriodScale times less often. Comes after the view priority node so it does not demote them again.
+ */
+UCLASS()
+class UDAReplicationGraphNode_Team_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+
+protected:
+
+	/** Team of the view target on the last gather, its members get their settings back when the connection changes team */
+	uint8 LastTeam = ADACharacter::NoTeam;
+
+	/** Teammates the character grid did not gather for the connection */
+	FActorRepListRefView UngatheredMembers;
+};
+
+/**
+ * Reports the lists gathered for one connection to the graph's rep list profile
+ *
+ * Has to come after every node that gathers actors for the connection.
+ */
+UCLASS()
+class UDAReplicationGraphNode_RepListTelemetry_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+};
+
+/**
+ * Reports the finished gather of one connection to the decision trace and the golden recorder while they are running
+ *
+ * Has to be the last node of the connection.
+ */
+UCLASS()
+class UDAReplicationGraphNode_Trace_ForConnection : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+};
+
+/**
+ * The actors of one packed grid cell stored as a structure of arrays,
+ * so the distance test against a viewer can be done four actors at a time
+ */
+struct FDAPackedGridCell
+{
+	TArray<FActorRepListType> Actors;
+	TArray<float> LocationX;
+	TArray<float> LocationY;
+	TArray<float> LocationZ;
+	TArray<float> CullDistanceSquared;
+
+	/** Number of connections whose view range covers this cell */
+	int32 NumViewers = 0;
+
+	/** Replication frame the packed locations were last refreshed on */
+	uint32 LastUpdateFrame = 0;
+
+	int32 Num() const { return Actors.Num(); }
+
+	int32 Add(FActorRepListType Actor, const FVector& Location, float InCullDistanceSquared);
+	void RemoveAtSwap(int32 Index);
+
+	/** Adds every actor that is within its cull distance of ViewLocation to OutList */
+	int32 GatherWithinCullDistance(const FVector& ViewLocation, FActorRepListRefView& OutList) const;
+};
+
+/**
+ * Grid node for dynamic actors with short cull distances such as projectiles
+ *
+ * Actor locations and cull distances are packed per cell and updated once per frame.
+ * When gathering, every cell within cull range of the viewer is tested with vector math
+ * and only the actors inside their cull distance are handed to the connection.
+ *
+ * The grid grows on demand instead of being rebuilt. Actors outside the allocated cells are kept in an
+ * overflow cell that every connection tests, and the missing rows / columns are added a few per frame.
+ */
+UCLASS()
+class UDAReplicationGraphNode_PackedGrid : public UReplicationGraphNode
+{
+public:
+
+	GENERATED_BODY()
+
+	UDAReplicationGraphNode_PackedGrid();
+
+	// ~ begin UReplicationGraphNode implementation
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// ~ end UReplicationGraphNode
+
+	float CellSize = 5000.f;
+	FVector2D SpatialBias = FVector2D::ZeroVector;
+
+	/** How many cells the grid may allocate per frame when it grows */
+	int32 MaxNewCellsPerFrame = 256;
+
+	/** The grid never grows past this many cells on either axis, actors beyond stay in the overflow cell */
+	int32 MaxCellsPerAxis = 512;
+
+	/** Cells that no connection is viewing are updated every this many frames instead of every frame */
+	int32 UnviewedCellUpdatePeriod = 8;
+
+	/** Bytes allocated by the cells, slots and viewer ranges of the grid */
+	SIZE_T GetAllocatedSize() const;
+
+	int32 GetNumCells() const { return GridSize.X * GridSize.Y; }
+
+	/** Adds every actor within Radius of Center on the XY plane to OutList, tested against the packed locations */
+	void GatherWithinRadius(const FVector2D& Center, float Radius, FActorRepListRefView& OutList) const;
+
+	/** The actors gathered for the connection this frame, null if the grid gave it nothing */
+	const FActorRepListRefView* GetGatheredActors(const UNetReplicationGraphConnection& Connection, uint32 FrameNum) const
+	{
+		return ((GatheredConnection == &Connection) && (GatheredFrame == FrameNum)) ? &GatheredActors : nullptr;
+	}
+
+protected:
+
+	/** Where an actor is stored in the grid, cell coordinates are absolute so growing the grid never moves them */
+	struct FActorCellSlot
+	{
+		int32 CellX;
+		int32 CellY;
+		int32 Index;
+	};
+
+	/** The absolute cell range a connection viewed on its last gather */
+	struct FViewerRange
+	{
+		FIntPoint Min;
+		FIntPoint Max;
+		uint32 LastGatherFrame;
+	};
+
+	/** Cell coordinate used for actors stored in the overflow cell */
+	static const int32 OverflowCellCoord = MAX_int32;
+
+	/** Viewers that have not gathered for this many frames no longer count towards NumViewers */
+	static const uint32 StaleViewerFrames = 30;
+
+	FIntPoint GetCellCoords(const FVector& Location) const;
+
+	bool IsInGrid(const FIntPoint& Coords) const;
+	FDAPackedGridCell& GetSlotCell(int32 CellX, int32 CellY);
+
+	/** Makes the grid grow towards Coords over the next frames. Returns false if Coords is too far away to ever be in the grid */
+	bool RequestGrowth(const FIntPoint& Coords);
+
+	/** Adds rows and columns towards the pending bounds until MaxNewCellsPerFrame is used up. Returns true if any cell was added */
+	bool GrowGrid();
+
+	/** Actors that left their cell and the absolute coordinates of the cell they moved into */
+	typedef TArray<TPair<FActorRepListType, FIntPoint>, TInlineAllocator<64>> FCellChangeArray;
+
+	/** Refreshes the packed locations and cull distances of a cell and collects the actors that left it */
+	void RefreshCell(FDAPackedGridCell& Cell, const FIntPoint& CellCoords, uint32 FrameNum, FCellChangeArray& OutActorsChangingCell);
+
+	/** Moves the actors collected by RefreshCell into their new cell */
+	void MoveActorsChangingCell(const FCellChangeArray& ActorsChangingCell);
+
+	void UpdateViewerRange(const UNetReplicationGraphConnection* Connection, const FIntPoint& Min, const FIntPoint& Max, uint32 FrameNum);
+	void ReleaseStaleViewers(uint32 FrameNum);
+	void AddViewerCount(const FIntPoint& Min, const FIntPoint& Max, int32 Delta);
+	void RebuildViewerCounts();
+
+	/** Puts the actor in the cell at Coords, or in the overflow cell if that cell is not allocated yet */
+	void AddToCell(FActorRepListType Actor, const FIntPoint& Coords, const FVector& Location, float CullDistSq);
+	void RemoveFromCell(const FActorCellSlot& Slot);
+
+	/** Cull distance used for actors with no cull distance set, they are always gathered */
+	static float GetPackedCullDistanceSquared(float CullDistSq) { return CullDistSq > 0.f ? CullDistSq : MAX_flt; }
+
+	TMap<FActorRepListType, FActorCellSlot> ActorSlots;
+
+	/** Cells indexed as Grid[X - GridOrigin.X][Y - GridOrigin.Y], every column has GridSize.Y cells */
+	TArray<TArray<FDAPackedGridCell>> Grid;
+
+	/** Absolute coordinates of Grid[0][0] */
+	FIntPoint GridOrigin = FIntPoint::ZeroValue;
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+
+	/** Inclusive cell bounds the grid is growing towards */
+	FIntPoint PendingMin = FIntPoint::ZeroValue;
+	FIntPoint PendingMax = FIntPoint::ZeroValue;
+
+	/** Actors that are outside the allocated cells, tested by every connection */
+	FDAPackedGridCell OverflowCell;
+
+	TMap<const UNetReplicationGraphConnection*, FViewerRange> ViewerRanges;
+
+	/** Largest cull distance of any actor in the grid, determines how many cells a viewer has to look at */
+	float MaxCullDistance = 0.f;
+	bool bHasUnculledActors = false;
+
+	/** Largest cull distance found since the start of the current unviewed cell update period */
+	float PeriodMaxCullDistSq = 0.f;
+	bool bPeriodHasUnculledActors = false;
+
+	/** Reused for every connection, gathering and replicating a connection is done before the next one is gathered */
+	FActorRepListRefView GatheredActors;
+
+	/** Connection and frame GatheredActors was last handed out for */
+	const UNetReplicationGraphConnection* GatheredConnection = nullptr;
+	uint32 GatheredFrame = 0;
+};
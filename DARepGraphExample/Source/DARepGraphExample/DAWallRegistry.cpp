@@ -0,0 +1,175 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+
+#include "DAWallRegistry.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "DABuildableWall.h"
+#include "DARepGraphExampleGameMode.h"
+
+DECLARE_STATS_GROUP(TEXT("DAWallRegistry"), STATGROUP_DAWallRegistry, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Try Build Wall"), STAT_DAWallRegistry_TryBuildWall, STATGROUP_DAWallRegistry);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Walls"), STAT_DAWallRegistry_Walls, STATGROUP_DAWallRegistry);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Budget"), STAT_DAWallRegistry_RejectedBudget, STATGROUP_DAWallRegistry);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Cell Full"), STAT_DAWallRegistry_RejectedCellFull, STATGROUP_DAWallRegistry);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Overlap"), STAT_DAWallRegistry_RejectedOverlap, STATGROUP_DAWallRegistry);
+
+UDAWallRegistry* UDAWallRegistry::Get(UWorld* World)
+{
+	ADARepGraphExampleGameMode* GameMode = World != NULL ? World->GetAuthGameMode<ADARepGraphExampleGameMode>() : nullptr;
+	return GameMode != nullptr ? GameMode->WallRegistry : nullptr;
+}
+
+bool UDAWallRegistry::TryBuildWall(AController* Builder, const FVector& Location)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DAWallRegistry_TryBuildWall);
+
+	if (Builder == NULL)
+	{
+		return false;
+	}
+
+	const float Now = GetWorld() != NULL ? GetWorld()->GetTimeSeconds() : 0.f;
+
+	FDABuildBudget* Budget = BuildBudgets.Find(Builder);
+	if (Budget == nullptr)
+	{
+		// Drop the budgets of players who left before adding a new one
+		for (auto It = BuildBudgets.CreateIterator(); It; ++It)
+		{
+			if (It.Key().IsValid() == false)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		Budget = &BuildBudgets.Add(Builder);
+		Budget->Builds = BuildBudget;
+		Budget->LastRefillTime = Now;
+	}
+
+	Budget->Builds = FMath::Min(BuildBudget, Budget->Builds + (Now - Budget->LastRefillTime) * BuildBudgetRefillRate);
+	Budget->LastRefillTime = Now;
+
+	if (Budget->Builds < 1.f)
+	{
+		INC_DWORD_STAT(STAT_DAWallRegistry_RejectedBudget);
+		return false;
+	}
+
+	if (WallsPerCell.FindRef(GetDensityCell(Location)) >= MaxWallsPerCell)
+	{
+		INC_DWORD_STAT(STAT_DAWallRegistry_RejectedCellFull);
+		return false;
+	}
+
+	if (HasWallNearby(Location) == true)
+	{
+		INC_DWORD_STAT(STAT_DAWallRegistry_RejectedOverlap);
+		return false;
+	}
+
+	Budget->Builds -= 1.f;
+	return true;
+}
+
+void UDAWallRegistry::RegisterWall(ADABuildableWall* Wall)
+{
+	if ((Wall == NULL) || (RegisteredWalls.Contains(Wall) == true))
+	{
+		return;
+	}
+
+	const FVector Location = Wall->GetActorLocation();
+	RegisteredWalls.Add(Wall, Location);
+
+	WallsPerCell.FindOrAdd(GetDensityCell(Location))++;
+	SpacingCells.FindOrAdd(GetSpacingCell(Location)).Add(Location);
+
+	INC_DWORD_STAT(STAT_DAWallRegistry_Walls);
+}
+
+void UDAWallRegistry::UnregisterWall(ADABuildableWall* Wall)
+{
+	FVector Location;
+	if (RegisteredWalls.RemoveAndCopyValue(Wall, Location) == false)
+	{
+		return;
+	}
+
+	const FIntPoint DensityCell = GetDensityCell(Location);
+	if (--WallsPerCell.FindChecked(DensityCell) == 0)
+	{
+		WallsPerCell.Remove(DensityCell);
+	}
+
+	const FIntVector SpacingCell = GetSpacingCell(Location);
+	TArray<FVector, TInlineAllocator<1>>& Locations = SpacingCells.FindChecked(SpacingCell);
+	Locations.RemoveSingleSwap(Location);
+	if (Locations.Num() == 0)
+	{
+		SpacingCells.Remove(SpacingCell);
+	}
+
+	DEC_DWORD_STAT(STAT_DAWallRegistry_Walls);
+}
+
+FIntPoint UDAWallRegistry::GetDensityCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / DensityCellSize), FMath::FloorToInt(Location.Y / DensityCellSize));
+}
+
+FIntVector UDAWallRegistry::GetSpacingCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / MinWallSpacing), FMath::FloorToInt(Location.Y / MinWallSpacing), FMath::FloorToInt(Location.Z / MinWallSpacing));
+}
+
+bool UDAWallRegistry::HasWallNearby(const FVector& Location) const
+{
+	const FIntVector Cell = GetSpacingCell(Location);
+	const float MinWallSpacingSquared = FMath::Square(MinWallSpacing);
+
+	for (int32 X = Cell.X - 1; X <= Cell.X + 1; ++X)
+	{
+		for (int32 Y = Cell.Y - 1; Y <= Cell.Y + 1; ++Y)
+		{
+			for (int32 Z = Cell.Z - 1; Z <= Cell.Z + 1; ++Z)
+			{
+				const TArray<FVector, TInlineAllocator<1>>* Locations = SpacingCells.Find(FIntVector(X, Y, Z));
+				if (Locations == nullptr)
+				{
+					continue;
+				}
+
+				for (const FVector& Other : *Locations)
+				{
+					if (FVector::DistSquared(Location, Other) < MinWallSpacingSquared)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
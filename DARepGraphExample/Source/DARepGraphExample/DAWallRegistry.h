@@ -0,0 +1,96 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "DAWallRegistry.generated.h"
+
+class ADABuildableWall;
+class AController;
+
+/** Builds left for a player, refilled over time */
+struct FDABuildBudget
+{
+	float Builds = 0.f;
+	float LastRefillTime = 0.f;
+};
+
+/**
+ * Tracks the walls of the world in a spatial hash and decides where new walls can be built
+ *
+ * A wall is rejected if its builder is out of build budget, if its grid cell already holds too many walls,
+ * or if another wall is closer than the min wall spacing. This keeps the number of walls per cell, and the cost
+ * of gathering them, bounded.
+ */
+UCLASS(config=Game)
+class DAREPGRAPHEXAMPLE_API UDAWallRegistry : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Checks if the builder can build a wall at the location and consumes one build of its budget if so */
+	bool TryBuildWall(AController* Builder, const FVector& Location);
+
+	void RegisterWall(ADABuildableWall* Wall);
+	void UnregisterWall(ADABuildableWall* Wall);
+
+	/** Gets the wall registry of the world's game mode, only valid on the server */
+	static UDAWallRegistry* Get(UWorld* World);
+
+	/** Max number of builds a player can store */
+	UPROPERTY(config)
+	float BuildBudget = 5.f;
+
+	/** Builds given back to every player per second */
+	UPROPERTY(config)
+	float BuildBudgetRefillRate = 0.5f;
+
+	/** Size of the cells the wall density is capped in, matches the replication grid cell size by default */
+	UPROPERTY(config)
+	float DensityCellSize = 10000.f;
+
+	UPROPERTY(config)
+	int32 MaxWallsPerCell = 64;
+
+	/** Walls closer than this to an existing wall are rejected as duplicates */
+	UPROPERTY(config)
+	float MinWallSpacing = 100.f;
+
+protected:
+
+	FIntPoint GetDensityCell(const FVector& Location) const;
+	FIntVector GetSpacingCell(const FVector& Location) const;
+
+	/** True if a wall is closer than the min wall spacing, only the neighbouring spacing cells have to be checked */
+	bool HasWallNearby(const FVector& Location) const;
+
+	TMap<TWeakObjectPtr<AController>, FDABuildBudget> BuildBudgets;
+
+	TMap<FIntPoint, int32> WallsPerCell;
+
+	/** Wall locations hashed by cells of the min wall spacing size */
+	TMap<FIntVector, TArray<FVector, TInlineAllocator<1>>> SpacingCells;
+
+	TMap<ADABuildableWall*, FVector> RegisteredWalls;
+};
@@ -20,6 +20,7 @@
 #include "UnrealNetwork.h"
 #include "DACharacter.h"
 #include "DAProjectile.h"
+#include "DAFireQueue.h"
 
 // Sets default values
 ADAWeapon::ADAWeapon()
@@ -65,17 +66,23 @@ FVector ADAWeapon::GetMuzzleLocation() const
 
 FVector ADAWeapon::GetAimLocation() const
 {
-	if (OwnerPawn != NULL)
+	return ComputeAimLocation(OwnerPawn);
+}
+
+FVector ADAWeapon::ComputeAimLocation(const APawn* Pawn)
+{
+	if (Pawn != NULL)
 	{
 		FVector Location;
 		FRotator Rotation;
-		OwnerPawn->GetActorEyesViewPoint(Location, Rotation);
+		Pawn->GetActorEyesViewPoint(Location, Rotation);
 
 		FHitResult OutHit(ForceInit);
-		FVector End = Rotation.Vector() * 10000000;
-		GetWorld()->LineTraceSingleByChannel(OutHit, Location, End, ECC_Visibility);
+		// Same range as the async aim traces of the fire queue, so both paths aim at the same point
+		FVector End = Location + Rotation.Vector() * GetDefault<UDAFireQueue>()->MaxAimTraceRange;
+		bool bHit = Pawn->GetWorld()->LineTraceSingleByChannel(OutHit, Location, End, ECC_Visibility);
 
-		return OutHit.Location;
+		return bHit ? OutHit.Location : End;
 	}
 	else
 	{
@@ -87,22 +94,21 @@ void ADAWeapon::FireWeapon()
 {
 	if (OwnerPawn != NULL && OwnerPawn->IsLocallyControlled() == true)
 	{
-		ServerFireWeapon(GetMuzzleLocation());
+		OwnerPawn->SendInputCommand(EDAInputCommandType::Fire, GetMuzzleLocation());
 	}
 }
 
 void ADAWeapon::ServerFireWeapon(const FVector& MuzzleLocation)
 {
-	if ((ProjectileClass != NULL) && (OwnerPawn != NULL))
+	if ((ProjectileClass != NULL) && (OwnerPawn != NULL) && (HasAuthority() == true))
 	{
-		if (HasAuthority() == true)
+		if (UDAFireQueue* FireQueue = UDAFireQueue::Get(GetWorld()))
 		{
-			FRotator Direction = (GetAimLocation() - MuzzleLocation).Rotation();
-			GetWorld()->SpawnActor<ADAProjectile>(ProjectileClass, FTransform(Direction, MuzzleLocation, FVector(0.25f, 0.25f, 0.25f)));
+			FireQueue->QueueFire(OwnerPawn, ProjectileClass, MuzzleLocation);
 		}
 		else
 		{
-			OwnerPawn->ServerFireWeapon(MuzzleLocation);
+			UDAFireQueue::SpawnProjectile(GetWorld(), ProjectileClass, MuzzleLocation, GetAimLocation());
 		}
 	}
 }
@@ -20,6 +20,7 @@
 
 #include "CoreMinimal.h"
 #include "Runtime/Engine/Classes/Animation/SkeletalMeshActor.h"
+#include "DAClassRepPolicy.h"
 #include "DAWeapon.generated.h"
 
 class ADAProjectile;
@@ -41,9 +42,19 @@ public:
 	FVector GetMuzzleLocation() const;
 	FVector GetAimLocation() const;
 
+	/** Traces from the eyes of the pawn to find what it is aiming at */
+	static FVector ComputeAimLocation(const APawn* Pawn);
+
 	virtual void FireWeapon();
 	virtual void ServerFireWeapon(const FVector& MuzzleLocation);
 
 	UPROPERTY(EditDefaultsOnly, Category="Weapon")
 	TSubclassOf<ADAProjectile> ProjectileClass;
+
+	/** Min time between two shots, enforced by the server */
+	UPROPERTY(EditDefaultsOnly, Category="Weapon")
+	float FireCooldown = 0.1f;
 };
+
+// Only used by the replication graph when the weapon replication tier is enabled
+DA_DECLARE_CLASS_REP_POLICY(ADAWeapon, Spatialize_Packed)
@@ -0,0 +1,133 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DAWeaponComponent.h"
+#include "UnrealNetwork.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "DACharacter.h"
+#include "DAWeapon.h"
+#include "DAProjectile.h"
+#include "DAFireQueue.h"
+
+UDAWeaponComponent::UDAWeaponComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UDAWeaponComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(UDAWeaponComponent, WeaponClass);
+	DOREPLIFETIME(UDAWeaponComponent, AttachSocketName);
+}
+
+void UDAWeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (CosmeticWeapon != nullptr)
+	{
+		CosmeticWeapon->Destroy();
+		CosmeticWeapon = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDAWeaponComponent::InitWeapon(TSubclassOf<ADAWeapon> InWeaponClass, FName InAttachSocketName)
+{
+	WeaponClass = InWeaponClass;
+	AttachSocketName = InAttachSocketName;
+
+	SpawnCosmeticWeapon();
+}
+
+FVector UDAWeaponComponent::GetMuzzleLocation() const
+{
+	if (CosmeticWeapon != NULL)
+	{
+		return CosmeticWeapon->GetMuzzleLocation();
+	}
+	else
+	{
+		return GetOwner()->GetActorLocation();
+	}
+}
+
+void UDAWeaponComponent::FireWeapon()
+{
+	ADACharacter* OwnerPawn = Cast<ADACharacter>(GetOwner());
+	if (OwnerPawn != NULL && OwnerPawn->IsLocallyControlled() == true)
+	{
+		OwnerPawn->SendInputCommand(EDAInputCommandType::Fire, GetMuzzleLocation());
+	}
+}
+
+void UDAWeaponComponent::ServerFireWeapon(const FVector& MuzzleLocation)
+{
+	ADACharacter* OwnerPawn = Cast<ADACharacter>(GetOwner());
+	if ((WeaponClass == NULL) || (OwnerPawn == NULL) || (OwnerPawn->HasAuthority() == false))
+	{
+		return;
+	}
+
+	TSubclassOf<ADAProjectile> ProjectileClass = WeaponClass->GetDefaultObject<ADAWeapon>()->ProjectileClass;
+	if (UDAFireQueue* FireQueue = UDAFireQueue::Get(GetWorld()))
+	{
+		FireQueue->QueueFire(OwnerPawn, ProjectileClass, MuzzleLocation);
+	}
+	else
+	{
+		UDAFireQueue::SpawnProjectile(GetWorld(), ProjectileClass, MuzzleLocation, ADAWeapon::ComputeAimLocation(OwnerPawn));
+	}
+}
+
+void UDAWeaponComponent::OnRep_WeaponClass()
+{
+	SpawnCosmeticWeapon();
+}
+
+void UDAWeaponComponent::SpawnCosmeticWeapon()
+{
+	if (CosmeticWeapon != nullptr)
+	{
+		CosmeticWeapon->Destroy();
+		CosmeticWeapon = nullptr;
+	}
+
+	// Dedicated servers never render the weapon, the muzzle location comes from the client
+	if ((WeaponClass == NULL) || (GetNetMode() == NM_DedicatedServer))
+	{
+		return;
+	}
+
+	ADACharacter* OwnerPawn = Cast<ADACharacter>(GetOwner());
+	if (OwnerPawn == NULL)
+	{
+		return;
+	}
+
+	CosmeticWeapon = GetWorld()->SpawnActorDeferred<ADAWeapon>(WeaponClass, FTransform(), OwnerPawn);
+	if (CosmeticWeapon != nullptr)
+	{
+		CosmeticWeapon->SetReplicates(false);
+		CosmeticWeapon->OwnerPawn = OwnerPawn;
+		CosmeticWeapon->FinishSpawning(FTransform());
+		CosmeticWeapon->AttachToComponent(OwnerPawn->GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, false), AttachSocketName);
+	}
+}
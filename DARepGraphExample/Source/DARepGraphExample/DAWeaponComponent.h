@@ -0,0 +1,70 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DAWeaponComponent.generated.h"
+
+class ADAWeapon;
+class ADAProjectile;
+
+/**
+ * Weapon state replicated as a subobject of the character that owns it
+ *
+ * Alternative to spawning a replicated ADAWeapon per character. Only the weapon class is replicated,
+ * every machine that renders the character spawns its own non replicated weapon actor for the mesh.
+ */
+UCLASS(ClassGroup=(Custom))
+class DAREPGRAPHEXAMPLE_API UDAWeaponComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDAWeaponComponent();
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Sets the weapon on the server, clients spawn their cosmetic weapon when it replicates */
+	void InitWeapon(TSubclassOf<ADAWeapon> InWeaponClass, FName InAttachSocketName);
+
+	FVector GetMuzzleLocation() const;
+
+	virtual void FireWeapon();
+	virtual void ServerFireWeapon(const FVector& MuzzleLocation);
+
+	UPROPERTY(ReplicatedUsing=OnRep_WeaponClass)
+	TSubclassOf<ADAWeapon> WeaponClass;
+
+	UPROPERTY(Replicated)
+	FName AttachSocketName;
+
+	/** Local only weapon actor used for the mesh and muzzle location */
+	UPROPERTY(Transient)
+	ADAWeapon* CosmeticWeapon;
+
+protected:
+
+	UFUNCTION()
+	void OnRep_WeaponClass();
+
+	void SpawnCosmeticWeapon();
+};
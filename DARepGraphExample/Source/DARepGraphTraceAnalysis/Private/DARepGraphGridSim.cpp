@@ -0,0 +1,254 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DARepGraphGridSim.h"
+#include "Misc/Parse.h"
+
+/** Parses a comma separated list, or returns the default list when the parameter is missing */
+static TArray<FString> ParseList(const FString& Params, const TCHAR* Key, const TArray<FString>& Default)
+{
+	FString Value;
+	if (FParse::Value(*Params, Key, Value) == false)
+	{
+		return Default;
+	}
+
+	TArray<FString> List;
+	Value.ParseIntoArray(List, TEXT(","));
+	return List;
+}
+
+bool FDAGridSimulator::Load(const FString& Filename, FOutputDevice& Ar)
+{
+	FDARepGraphTraceReader Reader;
+	if (Reader.Open(Filename, Ar) == false)
+	{
+		return false;
+	}
+
+	Frames.Reset();
+
+	while (Reader.Next() == true)
+	{
+		if (Reader.GetType() == EDARepGraphTraceRecord::Positions)
+		{
+			Frames.Add(Reader.GetPositions());
+		}
+	}
+
+	if (Frames.Num() == 0)
+	{
+		Ar.Logf(TEXT("%s has no positions, record it with DA.RepGraphTrace start positions"), *Filename);
+		return false;
+	}
+
+	RecordedMin = FVector2D(MAX_flt, MAX_flt);
+	for (const FDARepGraphTracePositions& Frame : Frames)
+	{
+		for (const FDARepGraphTracePositions::FViewer& Viewer : Frame.Viewers)
+		{
+			RecordedMin.X = FMath::Min(RecordedMin.X, Viewer.Location.X);
+			RecordedMin.Y = FMath::Min(RecordedMin.Y, Viewer.Location.Y);
+		}
+
+		for (const FDARepGraphTracePositions::FActor& Actor : Frame.Actors)
+		{
+			RecordedMin.X = FMath::Min(RecordedMin.X, Actor.Location.X);
+			RecordedMin.Y = FMath::Min(RecordedMin.Y, Actor.Location.Y);
+		}
+	}
+
+	if (RecordedMin.X == MAX_flt)
+	{
+		RecordedMin = FVector2D::ZeroVector;
+	}
+
+	return true;
+}
+
+bool FDAGridSimulator::IsSimulated(EDARepGraphTraceGrid Grid) const
+{
+	return (Grid != EDARepGraphTraceGrid::Packed) || bIncludePackedActors;
+}
+
+FDAGridSimResult FDAGridSimulator::Simulate(const FDAGridSimConfig& Config) const
+{
+	FDAGridSimResult Result;
+	Result.Config = Config;
+
+	const float CellSize = FMath::Max(Config.CellSize, 1.f);
+	const float CullScaleSq = FMath::Square(Config.CullScale);
+
+	auto GetCell = [&](const FVector2D& Location)
+	{
+		// Like the engine grid, nothing goes below the first cell
+		return FIntPoint(FMath::Max(FMath::FloorToInt((Location.X - Config.SpatialBias.X) / CellSize), 0), FMath::Max(FMath::FloorToInt((Location.Y - Config.SpatialBias.Y) / CellSize), 0));
+	};
+
+	// Cells every actor covered last frame, moving actors are only added to the cells they newly cover
+	TMap<uint32, FIntRect> ActorCells;
+	TMap<uint32, FIntRect> FrameActorCells;
+
+	TArray<FIntRect> Covered;
+	TArray<float> ScaledCullDistSq;
+
+	for (const FDARepGraphTracePositions& Frame : Frames)
+	{
+		Covered.Reset();
+		ScaledCullDistSq.Reset();
+		FrameActorCells.Reset();
+
+		FIntPoint GridMax(0, 0);
+
+		for (const FDARepGraphTracePositions::FActor& Actor : Frame.Actors)
+		{
+			const float CullDistSq = Actor.CullDistanceSquared * CullScaleSq;
+			const float CullDist = CullDistSq > 0.f ? FMath::Sqrt(CullDistSq) : 0.f;
+
+			const FVector2D Location(Actor.Location);
+			const FIntRect Cells(GetCell(Location - FVector2D(CullDist, CullDist)), GetCell(Location + FVector2D(CullDist, CullDist)));
+
+			Covered.Add(Cells);
+			ScaledCullDistSq.Add(CullDistSq);
+
+			if (IsSimulated(Actor.Grid) == false)
+			{
+				continue;
+			}
+
+			GridMax = GridMax.ComponentMax(Cells.Max);
+			FrameActorCells.Add(Actor.ActorId, Cells);
+
+			// Static actors are placed once, the others whenever the cells they cover change
+			const FIntRect* LastCells = ActorCells.Find(Actor.ActorId);
+			if (LastCells == nullptr)
+			{
+				Result.CellInserts += (uint64)(Cells.Width() + 1) * (Cells.Height() + 1);
+			}
+			else if ((*LastCells != Cells) && (Actor.Grid != EDARepGraphTraceGrid::Static))
+			{
+				const int32 OverlapX = FMath::Min(Cells.Max.X, LastCells->Max.X) - FMath::Max(Cells.Min.X, LastCells->Min.X) + 1;
+				const int32 OverlapY = FMath::Min(Cells.Max.Y, LastCells->Max.Y) - FMath::Max(Cells.Min.Y, LastCells->Min.Y) + 1;
+
+				const int64 Overlapping = ((OverlapX > 0) && (OverlapY > 0)) ? (int64)OverlapX * OverlapY : 0;
+				Result.CellInserts += (uint64)((int64)(Cells.Width() + 1) * (Cells.Height() + 1) - Overlapping);
+			}
+		}
+
+		Swap(ActorCells, FrameActorCells);
+
+		for (const FDARepGraphTracePositions::FViewer& Viewer : Frame.Viewers)
+		{
+			const FIntPoint ViewerCell = GetCell(FVector2D(Viewer.Location));
+			GridMax = GridMax.ComponentMax(ViewerCell);
+
+			++Result.NumViewerFrames;
+
+			for (int32 Idx = 0; Idx < Frame.Actors.Num(); ++Idx)
+			{
+				const FDARepGraphTracePositions::FActor& Actor = Frame.Actors[Idx];
+				if (IsSimulated(Actor.Grid) == false)
+				{
+					continue;
+				}
+
+				const FIntRect& Cells = Covered[Idx];
+				const bool bCandidate = (ViewerCell.X >= Cells.Min.X) && (ViewerCell.X <= Cells.Max.X) && (ViewerCell.Y >= Cells.Min.Y) && (ViewerCell.Y <= Cells.Max.Y);
+
+				const float DistSq = (Actor.Location - Viewer.Location).SizeSquared();
+				const bool bInRecordedRange = (Actor.CullDistanceSquared <= 0.f) || (DistSq <= Actor.CullDistanceSquared);
+				const bool bRelevant = bCandidate && ((ScaledCullDistSq[Idx] <= 0.f) || (DistSq <= ScaledCullDistSq[Idx]));
+
+				Result.Candidates += bCandidate ? 1 : 0;
+				Result.Relevant += bRelevant ? 1 : 0;
+				Result.OverReplicated += (bRelevant && (bInRecordedRange == false)) ? 1 : 0;
+				Result.Missed += ((bRelevant == false) && bInRecordedRange) ? 1 : 0;
+			}
+		}
+
+		Result.MaxCells = FMath::Max(Result.MaxCells, (int64)(GridMax.X + 1) * (GridMax.Y + 1));
+	}
+
+	return Result;
+}
+
+bool FDAGridSimulator::Sweep(const FString& Params, const FDAGridSimConfig& Recorded, FOutputDevice& Ar) const
+{
+	// Nothing recorded below this, a bias at it keeps the first row and column from collecting everything beyond the map
+	const FVector2D FittedBias = GetRecordedMin();
+
+	const TArray<FString> CellSizes = ParseList(Params, TEXT("cellsizes="), { FString::SanitizeFloat(Recorded.CellSize * 0.5f), FString::SanitizeFloat(Recorded.CellSize), FString::SanitizeFloat(Recorded.CellSize * 2.f) });
+	const TArray<FString> Biases = ParseList(Params, TEXT("biases="), { FString::Printf(TEXT("%.0f:%.0f"), Recorded.SpatialBias.X, Recorded.SpatialBias.Y), FString::Printf(TEXT("%.0f:%.0f"), FittedBias.X, FittedBias.Y) });
+	const TArray<FString> CullScales = ParseList(Params, TEXT("cullscales="), { TEXT("1.0") });
+
+	float InsertCost = 4.f;
+	FParse::Value(*Params, TEXT("insertcost="), InsertCost);
+
+	TArray<FDAGridSimResult> Results;
+
+	for (const FString& CellSize : CellSizes)
+	{
+		for (const FString& Bias : Biases)
+		{
+			FString BiasX;
+			FString BiasY;
+			if (Bias.Split(TEXT(":"), &BiasX, &BiasY) == false)
+			{
+				Ar.Logf(TEXT("Bias %s is not X:Y"), *Bias);
+				return false;
+			}
+
+			for (const FString& CullScale : CullScales)
+			{
+				FDAGridSimConfig Config;
+				Config.CellSize = FCString::Atof(*CellSize);
+				Config.SpatialBias = FVector2D(FCString::Atof(*BiasX), FCString::Atof(*BiasY));
+				Config.CullScale = FCString::Atof(*CullScale);
+
+				Results.Add(Simulate(Config));
+			}
+		}
+	}
+
+	Results.Sort([InsertCost](const FDAGridSimResult& A, const FDAGridSimResult& B) { return A.GetCost(InsertCost) < B.GetCost(InsertCost); });
+
+	Ar.Logf(TEXT("Grid simulation of %d frames, recorded with cell size %.0f and bias %.0f:%.0f (*)"), GetNumFrames(), Recorded.CellSize, Recorded.SpatialBias.X, Recorded.SpatialBias.Y);
+	Ar.Logf(TEXT("Per viewer and frame, cost is candidates plus %.1f per cell insert, cheapest first:"), InsertCost);
+	Ar.Logf(TEXT("  %10s %10s %10s %6s %10s %9s %10s %10s %12s %10s %12s"), TEXT("CellSize"), TEXT("BiasX"), TEXT("BiasY"), TEXT("Cull"), TEXT("Candidates"), TEXT("Relevant"), TEXT("OverRep"), TEXT("Missed"), TEXT("Inserts"), TEXT("Cells"), TEXT("Cost"));
+
+	for (const FDAGridSimResult& Result : Results)
+	{
+		const double ViewerFrames = FMath::Max<double>(Result.NumViewerFrames, 1.0);
+		const bool bRecorded = (Result.Config.CellSize == Recorded.CellSize) && (Result.Config.SpatialBias == Recorded.SpatialBias) && (Result.Config.CullScale == 1.f);
+
+		Ar.Logf(TEXT("%s %10.0f %10.0f %10.0f %6.2f %10.1f %8.1f%% %10.2f %10.2f %12.1f %10lld %12.1f"),
+			bRecorded ? TEXT("*") : TEXT(" "),
+			Result.Config.CellSize, Result.Config.SpatialBias.X, Result.Config.SpatialBias.Y, Result.Config.CullScale,
+			Result.Candidates / ViewerFrames,
+			Result.Candidates > 0 ? 100.0 * Result.Relevant / Result.Candidates : 0.0,
+			Result.OverReplicated / ViewerFrames,
+			Result.Missed / ViewerFrames,
+			Result.CellInserts / ViewerFrames,
+			Result.MaxCells,
+			Result.GetCost(InsertCost) / ViewerFrames);
+	}
+
+	return true;
+}
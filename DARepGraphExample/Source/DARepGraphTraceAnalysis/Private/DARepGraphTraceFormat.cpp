@@ -0,0 +1,346 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "DARepGraphTraceFormat.h"
+#include "Misc/FileHelper.h"
+
+/** Guards the array counts of a record read from a broken trace */
+static bool SerializeNum(FArchive& Ar, uint32& Num)
+{
+	Ar.SerializeIntPacked(Num);
+
+	if ((Ar.IsLoading() == true) && ((int64)Num > Ar.TotalSize() - Ar.Tell()))
+	{
+		Ar.SetError();
+		return false;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------
+// FDARepGraphTraceFrame
+
+void FDARepGraphTraceFrame::Serialize(FArchive& Ar)
+{
+	Ar.SerializeIntPacked(FrameNum);
+	Ar.SerializeIntPacked(ConnectionId);
+	Ar.SerializeIntPacked(Bits);
+
+	for (TArray<FCounts>* CountsArray : { &Nodes, &Classes })
+	{
+		uint32 Num = CountsArray->Num();
+		if (SerializeNum(Ar, Num) == false)
+		{
+			return;
+		}
+
+		CountsArray->SetNum(Num, false);
+
+		for (FCounts& Counts : *CountsArray)
+		{
+			Ar.SerializeIntPacked(Counts.Id);
+			Ar.SerializeIntPacked(Counts.NumLists);
+			Ar.SerializeIntPacked(Counts.Gathered);
+			Ar.SerializeIntPacked(Counts.Culled);
+			Ar.SerializeIntPacked(Counts.Sent);
+		}
+	}
+
+	uint32 NumActors = Actors.Num();
+	if (SerializeNum(Ar, NumActors) == false)
+	{
+		return;
+	}
+
+	Actors.SetNum(NumActors, false);
+
+	for (FActor& Actor : Actors)
+	{
+		Ar.SerializeIntPacked(Actor.ActorId);
+		Ar.SerializeIntPacked(Actor.ClassId);
+		Ar.SerializeIntPacked(Actor.NodeId);
+		Ar << Actor.Flags;
+	}
+}
+
+// --------------------------------------------------
+// FDARepGraphTracePositions
+
+void FDARepGraphTracePositions::Serialize(FArchive& Ar)
+{
+	Ar.SerializeIntPacked(FrameNum);
+
+	uint32 NumViewers = Viewers.Num();
+	if (SerializeNum(Ar, NumViewers) == false)
+	{
+		return;
+	}
+
+	Viewers.SetNum(NumViewers, false);
+
+	for (FViewer& Viewer : Viewers)
+	{
+		Ar.SerializeIntPacked(Viewer.ConnectionId);
+		Ar << Viewer.Location;
+	}
+
+	uint32 NumActors = Actors.Num();
+	if (SerializeNum(Ar, NumActors) == false)
+	{
+		return;
+	}
+
+	Actors.SetNum(NumActors, false);
+
+	for (FActor& Actor : Actors)
+	{
+		uint8 Grid = (uint8)Actor.Grid;
+
+		Ar.SerializeIntPacked(Actor.ActorId);
+		Ar.SerializeIntPacked(Actor.ClassId);
+		Ar << Grid;
+		Ar << Actor.CullDistanceSquared;
+		Ar << Actor.Location;
+
+		Actor.Grid = (EDARepGraphTraceGrid)Grid;
+	}
+}
+
+// --------------------------------------------------
+// FDARepGraphTraceReader
+
+bool FDARepGraphTraceReader::Open(const FString& Filename, FOutputDevice& Ar)
+{
+	Output = &Ar;
+
+	if (FFileHelper::LoadFileToArray(Data, *Filename) == false)
+	{
+		Ar.Logf(TEXT("Could not read %s"), *Filename);
+		return false;
+	}
+
+	Reader = MakeUnique<FMemoryReader>(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+
+	if ((Magic != DARepGraphTraceMagic) || (Version != DARepGraphTraceVersion))
+	{
+		Ar.Logf(TEXT("%s is not a replication graph trace of version %u"), *Filename, DARepGraphTraceVersion);
+		return false;
+	}
+
+	return true;
+}
+
+bool FDARepGraphTraceReader::Next()
+{
+	FMemoryReader& Ar = *Reader;
+
+	while ((Ar.AtEnd() == false) && (Ar.IsError() == false))
+	{
+		uint8 RecordType = 0;
+		Ar << RecordType;
+
+		Type = (EDARepGraphTraceRecord)RecordType;
+
+		switch (Type)
+		{
+		case EDARepGraphTraceRecord::Name:
+		{
+			uint32 Id = 0;
+			FString Name;
+			Ar.SerializeIntPacked(Id);
+			Ar << Name;
+
+			// Ids are handed out again after a dropped frame, the latest name is the one that applies
+			Names.Add(Id, Name);
+			break;
+		}
+
+		case EDARepGraphTraceRecord::Frame:
+			Frame.Serialize(Ar);
+			return Ar.IsError() == false;
+
+		case EDARepGraphTraceRecord::Positions:
+			Positions.Serialize(Ar);
+			return Ar.IsError() == false;
+
+		case EDARepGraphTraceRecord::End:
+			Ar.SerializeIntPacked(NumDropped);
+			return Ar.IsError() == false;
+
+		default:
+			Output->Logf(TEXT("Unknown record %u, the trace is cut off here"), RecordType);
+			return false;
+		}
+	}
+
+	return false;
+}
+
+FString FDARepGraphTraceReader::GetName(uint32 Id) const
+{
+	const FString* Name = Names.Find(Id);
+	return Name != nullptr ? *Name : FString::Printf(TEXT("#%u"), Id);
+}
+
+// --------------------------------------------------
+// FDARepGraphTraceAnalyzer
+
+bool FDARepGraphTraceAnalyzer::Analyze(const FString& Filename, FOutputDevice& Ar)
+{
+	FDARepGraphTraceReader Reader;
+	if (Reader.Open(Filename, Ar) == false)
+	{
+		return false;
+	}
+
+	struct FTotals
+	{
+		uint64 NumLists = 0;
+		uint64 Gathered = 0;
+		uint64 Culled = 0;
+		uint64 Sent = 0;
+		double EstimatedBits = 0.0;
+	};
+
+	struct FConnectionFrame
+	{
+		uint32 FrameNum;
+		uint32 ConnectionId;
+		uint32 Bits;
+		uint32 Gathered;
+		uint32 Sent;
+	};
+
+	TMap<FString, FTotals> NodeTotals;
+	TMap<FString, FTotals> ClassTotals;
+	TArray<FConnectionFrame> ConnectionFrames;
+	TSet<uint32> ConnectionIds;
+	uint64 TotalBits = 0;
+	uint32 MinFrame = MAX_uint32;
+	uint32 MaxFrame = 0;
+
+	while (Reader.Next() == true)
+	{
+		if (Reader.GetType() != EDARepGraphTraceRecord::Frame)
+		{
+			continue;
+		}
+
+		const FDARepGraphTraceFrame& TraceFrame = Reader.GetFrame();
+
+		FConnectionFrame& Frame = ConnectionFrames.AddDefaulted_GetRef();
+		Frame.FrameNum = TraceFrame.FrameNum;
+		Frame.ConnectionId = TraceFrame.ConnectionId;
+		Frame.Bits = TraceFrame.Bits;
+		Frame.Gathered = 0;
+		Frame.Sent = 0;
+
+		for (const FDARepGraphTraceFrame::FCounts& Counts : TraceFrame.Nodes)
+		{
+			FTotals& Totals = NodeTotals.FindOrAdd(Reader.GetName(Counts.Id));
+			Totals.NumLists += Counts.NumLists;
+			Totals.Gathered += Counts.Gathered;
+			Totals.Culled += Counts.Culled;
+			Totals.Sent += Counts.Sent;
+		}
+
+		for (const FDARepGraphTraceFrame::FCounts& Counts : TraceFrame.Classes)
+		{
+			Frame.Gathered += Counts.Gathered;
+			Frame.Sent += Counts.Sent;
+		}
+
+		for (const FDARepGraphTraceFrame::FCounts& Counts : TraceFrame.Classes)
+		{
+			FTotals& Totals = ClassTotals.FindOrAdd(Reader.GetName(Counts.Id));
+			Totals.Gathered += Counts.Gathered;
+			Totals.Culled += Counts.Culled;
+			Totals.Sent += Counts.Sent;
+
+			// Bits are only known per connection, they are split over the classes by the number of actors sent
+			if (Frame.Sent > 0)
+			{
+				Totals.EstimatedBits += (double)Frame.Bits * Counts.Sent / Frame.Sent;
+			}
+		}
+
+		ConnectionIds.Add(Frame.ConnectionId);
+		TotalBits += Frame.Bits;
+		MinFrame = FMath::Min(MinFrame, Frame.FrameNum);
+		MaxFrame = FMath::Max(MaxFrame, Frame.FrameNum);
+	}
+
+	if (ConnectionFrames.Num() == 0)
+	{
+		Ar.Logf(TEXT("%s has no frames"), *Filename);
+		return true;
+	}
+
+	Ar.Logf(TEXT("Trace %s"), *Filename);
+	Ar.Logf(TEXT("  Frames %u - %u, %d connections, %d connection frames, %u frames dropped"), MinFrame, MaxFrame, ConnectionIds.Num(), ConnectionFrames.Num(), Reader.GetNumDropped());
+	Ar.Logf(TEXT("  %llu bits written, %.0f bits per connection frame"), TotalBits, (double)TotalBits / ConnectionFrames.Num());
+
+	// ---------------------------------
+	// Hotspots
+
+	ConnectionFrames.Sort([](const FConnectionFrame& A, const FConnectionFrame& B) { return A.Bits > B.Bits; });
+
+	Ar.Logf(TEXT(""));
+	Ar.Logf(TEXT("Most expensive connection frames:"));
+	for (int32 Idx = 0; Idx < FMath::Min(ConnectionFrames.Num(), 10); ++Idx)
+	{
+		const FConnectionFrame& Frame = ConnectionFrames[Idx];
+		Ar.Logf(TEXT("  Frame %8u connection %8u: %8u bits, %5u gathered, %5u sent"), Frame.FrameNum, Frame.ConnectionId, Frame.Bits, Frame.Gathered, Frame.Sent);
+	}
+
+	// ---------------------------------
+	// Per class and per node
+
+	auto LogTotals = [&](const TCHAR* Title, TMap<FString, FTotals>& TotalsMap, bool bShowBits)
+	{
+		TotalsMap.ValueSort([&](const FTotals& A, const FTotals& B) { return bShowBits ? A.EstimatedBits > B.EstimatedBits : A.Gathered > B.Gathered; });
+
+		Ar.Logf(TEXT(""));
+		Ar.Logf(TEXT("%s"), Title);
+		Ar.Logf(TEXT("  %-48s %10s %10s %10s %8s %14s"), TEXT("Name"), TEXT("Gathered"), TEXT("Culled"), TEXT("Sent"), TEXT("Wasted"), bShowBits ? TEXT("Est. bits") : TEXT("Lists"));
+
+		for (const TPair<FString, FTotals>& Pair : TotalsMap)
+		{
+			const FTotals& Totals = Pair.Value;
+
+			// Gathered but never sent, the gather and the cull test were paid for nothing
+			const double WastedPct = Totals.Gathered > 0 ? 100.0 * (Totals.Gathered - Totals.Sent) / Totals.Gathered : 0.0;
+			const double LastColumn = bShowBits ? Totals.EstimatedBits : (double)Totals.NumLists;
+
+			Ar.Logf(TEXT("  %-48s %10llu %10llu %10llu %7.1f%% %14.0f"), *Pair.Key, Totals.Gathered, Totals.Culled, Totals.Sent, WastedPct, LastColumn);
+		}
+	};
+
+	LogTotals(TEXT("Per class, bits are estimated from the actors sent per connection frame:"), ClassTotals, true);
+	LogTotals(TEXT("Per node:"), NodeTotals, false);
+
+	return true;
+}
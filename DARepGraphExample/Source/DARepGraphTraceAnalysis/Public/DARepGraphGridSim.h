@@ -0,0 +1,102 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DARepGraphTraceFormat.h"
+
+/** Grid node settings one simulation run is done with */
+struct DAREPGRAPHTRACEANALYSIS_API FDAGridSimConfig
+{
+	float CellSize = 10000.f;
+	FVector2D SpatialBias = FVector2D::ZeroVector;
+
+	/** Multiplies the recorded class cull distances */
+	float CullScale = 1.f;
+};
+
+/** What a grid configuration would have done over the recorded frames */
+struct DAREPGRAPHTRACEANALYSIS_API FDAGridSimResult
+{
+	FDAGridSimConfig Config;
+
+	/** Viewers summed over the frames */
+	uint64 NumViewerFrames = 0;
+
+	/** Actors gathered from the cells of the viewers, every one of them gets a cull distance test */
+	uint64 Candidates = 0;
+
+	/** Candidates within their scaled cull distance, these would be replicated */
+	uint64 Relevant = 0;
+
+	/** Relevant actors beyond their recorded cull distance */
+	uint64 OverReplicated = 0;
+
+	/** Actors within their recorded cull distance the scaled cull distance drops */
+	uint64 Missed = 0;
+
+	/** Cells actors were added to when they moved into them */
+	uint64 CellInserts = 0;
+
+	/** Cells of the largest grid allocated, the grid is dense from the spatial bias to the furthest actor */
+	int64 MaxCells = 0;
+
+	/** Estimated gather and grid upkeep cost in cull test units */
+	double GetCost(double InsertCost) const { return (double)Candidates + InsertCost * CellInserts; }
+};
+
+/**
+ * Replays the recorded positions of a trace against other grid node settings
+ *
+ * Mirrors what the engine grid node does: spatialized actors are added to every cell their cull distance reaches,
+ * cells are counted from the spatial bias with everything below it clamped into the first row and column, and a
+ * viewer gathers the cell it is in. Only depends on Core, it runs in the DARepGraphTraceTool program as well as the commandlet.
+ */
+class DAREPGRAPHTRACEANALYSIS_API FDAGridSimulator
+{
+public:
+
+	/** Also simulates the actors the packed and character grids take, as if they were in the grid node */
+	bool bIncludePackedActors = false;
+
+	bool Load(const FString& Filename, FOutputDevice& Ar);
+
+	FDAGridSimResult Simulate(const FDAGridSimConfig& Config) const;
+
+	/**
+	 * Simulates every combination of the -cellsizes=, -biases= and -cullscales= lists in Params and logs the results cheapest
+	 * first, -insertcost= weighs the cell inserts. Recorded are the settings the trace was recorded with, the lists default to
+	 * around them. False when a parameter could not be parsed.
+	 */
+	bool Sweep(const FString& Params, const FDAGridSimConfig& Recorded, FOutputDevice& Ar) const;
+
+	int32 GetNumFrames() const { return Frames.Num(); }
+
+	/** Lowest X and Y of any recorded viewer or actor */
+	FVector2D GetRecordedMin() const { return RecordedMin; }
+
+protected:
+
+	bool IsSimulated(EDARepGraphTraceGrid Grid) const;
+
+	TArray<FDARepGraphTracePositions> Frames;
+	FVector2D RecordedMin = FVector2D::ZeroVector;
+};
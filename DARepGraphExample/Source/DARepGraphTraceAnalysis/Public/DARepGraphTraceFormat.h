@@ -0,0 +1,153 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/MemoryReader.h"
+
+/** "DART" */
+static const uint32 DARepGraphTraceMagic = 0x54524144;
+static const uint32 DARepGraphTraceVersion = 3;
+
+/** Records of a replication graph trace file, each starts with its type as one byte */
+enum class EDARepGraphTraceRecord : uint8
+{
+	Name,		// Id and name of a class or node, written before the first frame using it
+	Frame,		// One replication frame of one connection
+	End,		// Number of frames dropped while tracing
+	Positions	// Viewer and network actor positions of one frame, for the grid simulator
+};
+
+/** What happened to a gathered actor in a traced frame */
+enum class EDARepGraphTraceActorFlags : uint8
+{
+	None	= 0,
+	Culled	= 1 << 0,	// Beyond the cull distance of the connection
+	Sent	= 1 << 1	// Replicated to the connection this frame
+};
+
+ENUM_CLASS_FLAGS(EDARepGraphTraceActorFlags);
+
+/** Which grid a spatialized actor of a positions record is kept in */
+enum class EDARepGraphTraceGrid : uint8
+{
+	Static,		// Grid node, placed once
+	Dynamic,	// Grid node, moved with the actor, dormant actors included
+	Packed		// Packed or character grid
+};
+
+/** Gathered, culled and sent counts of one connection in one frame */
+struct DAREPGRAPHTRACEANALYSIS_API FDARepGraphTraceFrame
+{
+	struct FCounts
+	{
+		uint32 Id;	// Node or class name id
+		uint32 NumLists;
+		uint32 Gathered;
+		uint32 Culled;
+		uint32 Sent;
+	};
+
+	struct FActor
+	{
+		uint32 ActorId;
+		uint32 ClassId;
+		uint32 NodeId;
+		uint8 Flags;	// EDARepGraphTraceActorFlags
+	};
+
+	uint32 FrameNum = 0;
+	uint32 ConnectionId = 0;
+	uint32 Bits = 0;
+
+	TArray<FCounts> Nodes;
+	TArray<FCounts> Classes;
+
+	/** Only with actor detail */
+	TArray<FActor> Actors;
+
+	void Serialize(FArchive& Ar);
+};
+
+/** Where the viewers and spatialized actors were in one frame */
+struct DAREPGRAPHTRACEANALYSIS_API FDARepGraphTracePositions
+{
+	struct FViewer
+	{
+		uint32 ConnectionId;
+		FVector Location;
+	};
+
+	struct FActor
+	{
+		uint32 ActorId;
+		uint32 ClassId;
+		EDARepGraphTraceGrid Grid;
+		float CullDistanceSquared;
+		FVector Location;
+	};
+
+	uint32 FrameNum = 0;
+
+	TArray<FViewer> Viewers;
+	TArray<FActor> Actors;
+
+	void Serialize(FArchive& Ar);
+};
+
+/** Reads the records of a trace file in order, name records are resolved while reading */
+class DAREPGRAPHTRACEANALYSIS_API FDARepGraphTraceReader
+{
+public:
+
+	bool Open(const FString& Filename, FOutputDevice& Ar);
+
+	/** Reads the next frame, positions or end record, false once the trace ends or is cut off */
+	bool Next();
+
+	EDARepGraphTraceRecord GetType() const { return Type; }
+
+	/** Name of a node or class id of the current record */
+	FString GetName(uint32 Id) const;
+
+	const FDARepGraphTraceFrame& GetFrame() const { return Frame; }
+	const FDARepGraphTracePositions& GetPositions() const { return Positions; }
+	uint32 GetNumDropped() const { return NumDropped; }
+
+protected:
+
+	TArray<uint8> Data;
+	TUniquePtr<FMemoryReader> Reader;
+	FOutputDevice* Output = nullptr;
+
+	EDARepGraphTraceRecord Type = EDARepGraphTraceRecord::End;
+	TMap<uint32, FString> Names;
+
+	FDARepGraphTraceFrame Frame;
+	FDARepGraphTracePositions Positions;
+	uint32 NumDropped = 0;
+};
+
+/** Summarizes a trace file: hotspots, per class bandwidth and gathers that were never sent */
+struct DAREPGRAPHTRACEANALYSIS_API FDARepGraphTraceAnalyzer
+{
+	static bool Analyze(const FString& Filename, FOutputDevice& Ar);
+};
@@ -0,0 +1,87 @@
+// Copyright (C) 2018 - Dennis "MazyModz" Andersson.
+
+/*
+
+	MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit
+ persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ */
+
+#include "CoreMinimal.h"
+#include "RequiredProgramMainCPPInclude.h"
+#include "Misc/Parse.h"
+#include "DARepGraphTraceFormat.h"
+#include "DARepGraphGridSim.h"
+
+IMPLEMENT_APPLICATION(DARepGraphTraceTool, "DARepGraphTraceTool");
+
+/**
+ * Summarizes or grid simulates a replication graph trace without the editor, takes the same parameters as the commandlet
+ *
+ * DARepGraphTraceTool -file=<trace> [-gridsim [-cellsize=10000] [-bias=X:Y] ...], the program cannot read the project config
+ * so -cellsize= and -bias= tell it what the trace was recorded with.
+ */
+static int32 Run(const TCHAR* Params)
+{
+	FString Filename;
+	if (FParse::Value(Params, TEXT("file="), Filename) == false)
+	{
+		GLog->Logf(TEXT("Pass a trace with -file="));
+		return 1;
+	}
+
+	if (FParse::Param(Params, TEXT("gridsim")) == false)
+	{
+		return FDARepGraphTraceAnalyzer::Analyze(Filename, *GLog) == true ? 0 : 1;
+	}
+
+	FDAGridSimulator Simulator;
+	Simulator.bIncludePackedActors = FParse::Param(Params, TEXT("allgrid"));
+
+	if (Simulator.Load(Filename, *GLog) == false)
+	{
+		return 1;
+	}
+
+	FDAGridSimConfig Recorded;
+	FParse::Value(Params, TEXT("cellsize="), Recorded.CellSize);
+
+	FString Bias;
+	if (FParse::Value(Params, TEXT("bias="), Bias) == true)
+	{
+		FString BiasX;
+		FString BiasY;
+		if (Bias.Split(TEXT(":"), &BiasX, &BiasY) == false)
+		{
+			GLog->Logf(TEXT("Bias %s is not X:Y"), *Bias);
+			return 1;
+		}
+
+		Recorded.SpatialBias = FVector2D(FCString::Atof(*BiasX), FCString::Atof(*BiasY));
+	}
+
+	GLog->Logf(TEXT("Grid simulation of %s"), *Filename);
+	return Simulator.Sweep(Params, Recorded, *GLog) == true ? 0 : 1;
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV);
+
+	const int32 Result = Run(FCommandLine::Get());
+
+	GLog->Flush();
+	FEngineLoop::AppExit();
+	return Result;
+}